@@ -0,0 +1,501 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "engine/world.h"
+#include "engine/scenarios.h"
+#include "engine/perf_counters.h"
+#include "frame_capture.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+// ----------------------------
+// Benchmark
+// ----------------------------
+// Runs the named scenarios from engine/scenarios.h headless and reports
+//   - steps per second
+//   - ns per particle-substep (wall time / (balls * substeps run))
+//   - broadphase pairs tested vs. pairs actually touching
+//   - peak resident memory of the process
+//
+//     bench                        all scenarios
+//     bench --list                 scenario names
+//     bench --scenario stress_10k  one scenario (repeatable)
+//     bench --threads 8            collision threads (0 = one per core)
+//     bench --steps 100            override the measured step count
+//     bench --precision both       float, double or both (default: Scalar)
+//     bench --json out.json        also write the results as JSON
+//     bench --adaptive             adaptive substeps (up to each scenario's
+//                                  fixed count), average count reported
+//     bench --solver jacobi        Jacobi instead of Gauss-Seidel collisions
+//     bench --broadphase multilevel  multi-level grid instead of the uniform one
+//     bench --reorder 60           Morton-reorder the balls every 60 steps
+//     bench --render 1920x1080     also draw every measured step off-screen
+//                                  (steps/s and ns/p-substep then include it)
+//     bench --perf                 hardware counters (Linux perf_event_open):
+//                                  IPC, L1D / LLC misses per 1000 instructions
+//                                  and branch miss rate per frame; per phase
+//                                  too when built with -DENGINE_PERF
+//
+// Counters only see the bench thread, so use them with --threads 1 (the
+// default) unless the calling thread's share is what you want; with any
+// other count the table and the JSON say so ("calling_thread_only").
+//
+// Peak RSS is a process-wide high-water mark, so run one scenario per
+// process when comparing memory between builds.
+
+// World settings applied on top of every scenario's own
+struct BenchOptions
+{
+    int threads = 1;
+    int steps = 0;              // measured steps, 0 = the scenario's
+    bool adaptive = false;
+    SolverMode solver = SOLVER_GAUSS_SEIDEL;
+    BroadphaseMode broadphase = BROADPHASE_GRID;
+    int reorderInterval = 0;
+    int renderWidth = 0;        // 0 = no rendering
+    int renderHeight = 0;
+    bool perf = false;          // counters opened (--perf and available)
+};
+
+struct BenchResult
+{
+    std::string name;
+    const char* precision = "";
+    int balls = 0;
+    int substeps = 0;           // fixed count, or the adaptive maximum
+    double substepsAvg = 0.0;   // substeps actually run per measured step
+    int steps = 0;
+    double seconds = 0.0;
+    double stepsPerSec = 0.0;
+    double nsPerParticleSubstep = 0.0;
+    long long pairsTested = 0;
+    long long contacts = 0;
+    int sleepingBalls = 0;      // at the end of the run
+    long long peakRssKb = 0;
+
+    // Hardware counters over the measured steps (options.perf only)
+    bool perf = false;
+    bool perfCallingThreadOnly = false;         // threads != 1: workers not counted
+    PerfCounts perfTotal;                       // all frames
+    std::vector<PerfCounts> perfFrames;         // one per measured step
+    PerfCounts perfPhase[PERF_PHASE_COUNT];     // -DENGINE_PERF builds
+    long long perfPhaseCalls[PERF_PHASE_COUNT] = {};
+};
+
+long long PeakRssKb()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return (long long)(counters.PeakWorkingSetSize / 1024);
+    return 0;
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024;   // bytes on macOS
+#else
+    return usage.ru_maxrss;          // KB on Linux
+#endif
+#endif
+}
+
+template <typename T>
+BenchResult RunScenario(const ScenarioInfo& info, const BenchOptions& options)
+{
+    const double dt = 1.0 / 60.0;
+    std::unique_ptr<BasicWorld<T> > world = CreateScenario<T>(info.name, options.threads);
+    const WorldConfig& base = world->config();
+    if (options.adaptive || options.solver != base.solver || options.broadphase != base.broadphase ||
+        options.reorderInterval != base.reorderInterval) {
+        // Same scene; adaptive substeps use the scenario's fixed count as
+        // the ceiling
+        WorldConfig config = base;
+        config.adaptiveSubsteps = options.adaptive;
+        config.maxSubsteps = config.substeps;
+        config.solver = options.solver;
+        config.broadphase = options.broadphase;
+        config.reorderInterval = options.reorderInterval;
+        std::unique_ptr<BasicWorld<T> > w(new BasicWorld<T>(config));
+        w->particles() = world->particles();
+        world = std::move(w);
+    }
+
+    for (int s = 0; s < info.warmupSteps; s++)
+        world->step(dt);
+
+    BenchResult r;
+    r.name = info.name;
+    r.precision = (sizeof(T) == sizeof(float)) ? "float" : "double";
+    r.balls = world->ballCount();
+    r.substeps = world->config().substeps;
+    r.steps = (options.steps > 0) ? options.steps : info.steps;
+
+    CaptureFrame frame;
+    CaptureView view;
+    if (options.renderWidth > 0) {
+        frame.width = options.renderWidth;
+        frame.height = options.renderHeight;
+        frame.pixels.resize((size_t)frame.width * frame.height);
+        view = FitView(world->config(), frame.width, frame.height);
+    }
+
+    PerfCounters& perf = GlobalPerfCounters();
+    r.perf = options.perf;
+    r.perfCallingThreadOnly = options.perf && options.threads != 1;
+    if (r.perf) {
+        perf.ResetPhases();
+        r.perfFrames.reserve(r.steps);
+    }
+
+    long long substepsRun = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (int s = 0; s < r.steps; s++) {
+        PerfReading before, after;
+        if (r.perf)
+            perf.Read(before);
+
+        world->step(dt);
+        if (options.renderWidth > 0)
+            RenderFrame(frame, world->particles(), view, &world->threadPool(), &world->config());
+
+        if (r.perf && perf.Read(after)) {
+            r.perfFrames.push_back(perf.Delta(before, after));
+            r.perfTotal.Add(r.perfFrames.back());
+        }
+        r.pairsTested += world->stats().pairsTested;
+        r.contacts += world->stats().contacts;
+        substepsRun += world->stats().substeps;
+    }
+    auto end = std::chrono::steady_clock::now();
+    if (r.perf) {
+        for (int p = 0; p < PERF_PHASE_COUNT; p++) {
+            r.perfPhase[p] = perf.phase[p];
+            r.perfPhaseCalls[p] = perf.phaseCalls[p];
+        }
+    }
+    r.sleepingBalls = world->stats().sleepingBalls;
+
+    r.seconds = std::chrono::duration<double>(end - begin).count();
+    r.stepsPerSec = r.steps / r.seconds;
+    r.substepsAvg = (r.steps > 0) ? (double)substepsRun / r.steps : 0.0;
+    double particleSubsteps = (double)substepsRun * r.balls;
+    r.nsPerParticleSubstep = (particleSubsteps > 0.0) ? r.seconds * 1e9 / particleSubsteps : 0.0;
+    r.peakRssKb = PeakRssKb();
+    return r;
+}
+
+// Per-frame IPC, sorted (frames whose IPC was not counted are left out)
+std::vector<double> FrameIpc(const BenchResult& r)
+{
+    std::vector<double> ipc;
+    for (size_t k = 0; k < r.perfFrames.size(); k++)
+        if (r.perfFrames[k].Ipc() >= 0.0)
+            ipc.push_back(r.perfFrames[k].Ipc());
+    std::sort(ipc.begin(), ipc.end());
+    return ipc;
+}
+
+// "-" for a ratio that was not counted
+const char* FormatMetric(char* buffer, size_t size, double value, const char* format)
+{
+    if (value < 0.0)
+        snprintf(buffer, size, "-");
+    else
+        snprintf(buffer, size, format, value);
+    return buffer;
+}
+
+void PrintPerfRow(const char* name, long long calls, int steps, const PerfCounts& c)
+{
+    char mcycles[32], ipc[32], l1d[32], llc[32], branch[32];
+    double perStep = (c.counted[PERF_CYCLES] && steps > 0) ? c.value[PERF_CYCLES] / steps / 1e6 : -1.0;
+    printf("  %-14s %8lld %11s %6s %9s %9s %10s\n", name, calls,
+           FormatMetric(mcycles, sizeof(mcycles), perStep, "%.3f"),
+           FormatMetric(ipc, sizeof(ipc), c.Ipc(), "%.2f"),
+           FormatMetric(l1d, sizeof(l1d), c.Mpki(PERF_L1D_MISSES), "%.2f"),
+           FormatMetric(llc, sizeof(llc), c.Mpki(PERF_LLC_MISSES), "%.3f"),
+           FormatMetric(branch, sizeof(branch), c.BranchMissPercent(), "%.2f"));
+}
+
+// Counter table under a scenario's row: the whole frame, then every phase
+// that ran
+void PrintPerf(const BenchResult& r)
+{
+    printf("  %-14s %8s %11s %6s %9s %9s %10s\n",
+           r.perfCallingThreadOnly ? "counters (*)" : "counters",
+           "calls", "Mcycles/st", "IPC", "L1D MPKI", "LLC MPKI", "br miss %");
+    PrintPerfRow("frame", (long long)r.perfFrames.size(), r.steps, r.perfTotal);
+    for (int p = 0; p < PERF_PHASE_COUNT; p++)
+        if (r.perfPhaseCalls[p] > 0)
+            PrintPerfRow(PerfPhaseName(p), r.perfPhaseCalls[p], r.steps, r.perfPhase[p]);
+
+    std::vector<double> ipc = FrameIpc(r);
+    if (!ipc.empty())
+        printf("  frame IPC      min %.2f  median %.2f  max %.2f\n",
+               ipc.front(), ipc[ipc.size() / 2], ipc.back());
+    if (r.perfCallingThreadOnly)
+        printf("  (*) calling thread only: work on the pool's worker threads is not counted\n");
+}
+
+// Value or null
+void WriteJsonMetric(FILE* f, const char* name, double value, const char* separator)
+{
+    if (value < 0.0)
+        fprintf(f, "\"%s\": null%s", name, separator);
+    else
+        fprintf(f, "\"%s\": %.4f%s", name, value, separator);
+}
+
+// One line: raw counts (null if not counted) and the ratios
+void WriteJsonCounts(FILE* f, const PerfCounts& c)
+{
+    fprintf(f, "{");
+    for (int e = 0; e < PERF_EVENT_COUNT; e++) {
+        if (c.counted[e])
+            fprintf(f, "\"%s\": %.0f, ", PerfEventName(e), c.value[e]);
+        else
+            fprintf(f, "\"%s\": null, ", PerfEventName(e));
+    }
+    WriteJsonMetric(f, "ipc", c.Ipc(), ", ");
+    WriteJsonMetric(f, "l1d_mpki", c.Mpki(PERF_L1D_MISSES), ", ");
+    WriteJsonMetric(f, "llc_mpki", c.Mpki(PERF_LLC_MISSES), ", ");
+    WriteJsonMetric(f, "branch_miss_pct", c.BranchMissPercent(), "");
+    fprintf(f, "}");
+}
+
+void WriteJsonPerf(FILE* f, const BenchResult& r)
+{
+    fprintf(f, "      \"perf\": {\n");
+    fprintf(f, "        \"calling_thread_only\": %s,\n", r.perfCallingThreadOnly ? "true" : "false");
+    fprintf(f, "        \"total\": ");
+    WriteJsonCounts(f, r.perfTotal);
+    fprintf(f, ",\n");
+
+    std::vector<double> ipc = FrameIpc(r);
+    fprintf(f, "        ");
+    WriteJsonMetric(f, "frame_ipc_min", ipc.empty() ? -1.0 : ipc.front(), ", ");
+    WriteJsonMetric(f, "frame_ipc_median", ipc.empty() ? -1.0 : ipc[ipc.size() / 2], ", ");
+    WriteJsonMetric(f, "frame_ipc_max", ipc.empty() ? -1.0 : ipc.back(), ",\n");
+
+    fprintf(f, "        \"phases\": {");
+    bool first = true;
+    for (int p = 0; p < PERF_PHASE_COUNT; p++) {
+        if (r.perfPhaseCalls[p] == 0)
+            continue;
+        fprintf(f, "%s\n          \"%s\": ", first ? "" : ",", PerfPhaseName(p));
+        WriteJsonCounts(f, r.perfPhase[p]);
+        first = false;
+    }
+    fprintf(f, "%s},\n", first ? "" : "\n        ");
+
+    fprintf(f, "        \"frames\": [");
+    for (size_t k = 0; k < r.perfFrames.size(); k++) {
+        fprintf(f, "%s\n          ", k > 0 ? "," : "");
+        WriteJsonCounts(f, r.perfFrames[k]);
+    }
+    fprintf(f, "%s]\n", r.perfFrames.empty() ? "" : "\n        ");
+    fprintf(f, "      }\n");
+}
+
+void WriteJson(const char* path, const std::vector<BenchResult>& results, const BenchOptions& options)
+{
+    FILE* f = fopen(path, "w");
+    if (!f) {
+        fprintf(stderr, "bench: cannot write %s\n", path);
+        return;
+    }
+
+    fprintf(f, "{\n");
+    fprintf(f, "  \"build\": {\n");
+#if defined(__clang__)
+    fprintf(f, "    \"compiler\": \"clang %s\",\n", __clang_version__);
+#elif defined(__GNUC__)
+    fprintf(f, "    \"compiler\": \"gcc %s\",\n", __VERSION__);
+#else
+    fprintf(f, "    \"compiler\": \"unknown\",\n");
+#endif
+    fprintf(f, "    \"simd_lanes\": %d,\n", SIMD_LANES);
+    fprintf(f, "    \"simd_lanes_float\": %d,\n", SIMD_LANES_FLOAT);
+    fprintf(f, "    \"threads\": %d,\n", options.threads);
+    fprintf(f, "    \"adaptive_substeps\": %s,\n", options.adaptive ? "true" : "false");
+    fprintf(f, "    \"solver\": \"%s\",\n", options.solver == SOLVER_JACOBI ? "jacobi" : "gauss-seidel");
+    fprintf(f, "    \"broadphase\": \"%s\",\n", options.broadphase == BROADPHASE_MULTILEVEL ? "multilevel" : "grid");
+    fprintf(f, "    \"reorder_interval\": %d,\n", options.reorderInterval);
+    fprintf(f, "    \"render\": \"%dx%d\",\n", options.renderWidth, options.renderHeight);
+    fprintf(f, "    \"perf\": %s,\n", options.perf ? "true" : "false");
+#ifdef ENGINE_PERF
+    fprintf(f, "    \"perf_phases\": true\n");
+#else
+    fprintf(f, "    \"perf_phases\": false\n");
+#endif
+    fprintf(f, "  },\n");
+    fprintf(f, "  \"scenarios\": [\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult& r = results[i];
+        fprintf(f, "    {\n");
+        fprintf(f, "      \"name\": \"%s\",\n", r.name.c_str());
+        fprintf(f, "      \"precision\": \"%s\",\n", r.precision);
+        fprintf(f, "      \"balls\": %d,\n", r.balls);
+        fprintf(f, "      \"substeps\": %d,\n", r.substeps);
+        fprintf(f, "      \"substeps_avg\": %.3f,\n", r.substepsAvg);
+        fprintf(f, "      \"steps\": %d,\n", r.steps);
+        fprintf(f, "      \"seconds\": %.6f,\n", r.seconds);
+        fprintf(f, "      \"steps_per_sec\": %.3f,\n", r.stepsPerSec);
+        fprintf(f, "      \"ns_per_particle_substep\": %.3f,\n", r.nsPerParticleSubstep);
+        fprintf(f, "      \"pairs_tested\": %lld,\n", r.pairsTested);
+        fprintf(f, "      \"pairs_colliding\": %lld,\n", r.contacts);
+        fprintf(f, "      \"sleeping_balls\": %d,\n", r.sleepingBalls);
+        fprintf(f, "      \"peak_rss_kb\": %lld%s\n", r.peakRssKb, r.perf ? "," : "");
+        if (r.perf)
+            WriteJsonPerf(f, r);
+        fprintf(f, "    }%s\n", (i + 1 < results.size()) ? "," : "");
+    }
+    fprintf(f, "  ]\n");
+    fprintf(f, "}\n");
+    fclose(f);
+}
+
+int main(int argc, char* argv[])
+{
+    std::vector<const ScenarioInfo*> selected;
+    const char* jsonPath = nullptr;
+    BenchOptions options;
+    bool runFloat = (sizeof(Scalar) == sizeof(float));
+    bool runDouble = !runFloat;
+    bool perf = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--list") == 0) {
+            for (int s = 0; s < SCENARIO_COUNT; s++)
+                printf("%-14s %s\n", SCENARIOS[s].name, SCENARIOS[s].description);
+            return 0;
+        }
+        else if (strcmp(argv[i], "--scenario") == 0 && i + 1 < argc) {
+            const ScenarioInfo* info = FindScenario(argv[++i]);
+            if (!info) {
+                fprintf(stderr, "bench: unknown scenario '%s' (see --list)\n", argv[i]);
+                return 1;
+            }
+            selected.push_back(info);
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            options.threads = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--steps") == 0 && i + 1 < argc) {
+            options.steps = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--precision") == 0 && i + 1 < argc) {
+            const char* p = argv[++i];
+            runFloat = (strcmp(p, "float") == 0 || strcmp(p, "both") == 0);
+            runDouble = (strcmp(p, "double") == 0 || strcmp(p, "both") == 0);
+            if (!runFloat && !runDouble) {
+                fprintf(stderr, "bench: --precision is float, double or both\n");
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            jsonPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--adaptive") == 0) {
+            options.adaptive = true;
+        }
+        else if (strcmp(argv[i], "--solver") == 0 && i + 1 < argc) {
+            const char* m = argv[++i];
+            if (strcmp(m, "jacobi") == 0)
+                options.solver = SOLVER_JACOBI;
+            else if (strcmp(m, "gauss-seidel") == 0)
+                options.solver = SOLVER_GAUSS_SEIDEL;
+            else {
+                fprintf(stderr, "bench: --solver is gauss-seidel or jacobi\n");
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--reorder") == 0 && i + 1 < argc) {
+            options.reorderInterval = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--broadphase") == 0 && i + 1 < argc) {
+            const char* m = argv[++i];
+            if (strcmp(m, "multilevel") == 0)
+                options.broadphase = BROADPHASE_MULTILEVEL;
+            else if (strcmp(m, "grid") == 0)
+                options.broadphase = BROADPHASE_GRID;
+            else {
+                fprintf(stderr, "bench: --broadphase is grid or multilevel\n");
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--render") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%dx%d", &options.renderWidth, &options.renderHeight) != 2 ||
+                options.renderWidth <= 0 || options.renderHeight <= 0) {
+                fprintf(stderr, "bench: --render takes WIDTHxHEIGHT\n");
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--perf") == 0) {
+            perf = true;
+        }
+        else {
+            fprintf(stderr, "usage: bench [--list] [--scenario NAME]... [--threads N] [--steps N] [--precision float|double|both] [--json FILE] [--adaptive] [--solver gauss-seidel|jacobi] [--broadphase grid|multilevel] [--reorder N] [--render WxH] [--perf]\n");
+            return 1;
+        }
+    }
+
+    if (selected.empty())
+        for (int s = 0; s < SCENARIO_COUNT; s++)
+            selected.push_back(&SCENARIOS[s]);
+
+    if (perf) {
+        PerfCounters& counters = GlobalPerfCounters();
+        options.perf = counters.Open();
+        if (!options.perf)
+            fprintf(stderr, "bench: no hardware counters: %s\n", counters.Error());
+#ifndef ENGINE_PERF
+        else
+            fprintf(stderr, "bench: per-frame counters only; build with -DENGINE_PERF for per-phase\n");
+#endif
+        if (options.perf && options.threads != 1)
+            fprintf(stderr, "bench: --threads %d: counters cover the calling thread only, not the workers\n",
+                    options.threads);
+        for (int e = 0; options.perf && e < PERF_EVENT_COUNT; e++)
+            if (!counters.Has(e))
+                fprintf(stderr, "bench: %s not counted on this CPU, shown as '-'\n", PerfEventName(e));
+    }
+
+    printf("%-14s %6s %8s %7s %9s %11s %12s %14s %14s %10s\n",
+           "scenario", "prec", "balls", "steps", "substeps", "steps/s", "ns/p-substep",
+           "pairs tested", "colliding", "peak MB");
+
+    std::vector<BenchResult> results;
+    for (size_t i = 0; i < selected.size(); i++) {
+        for (int pass = 0; pass < 2; pass++) {
+            // Same scenario, same seed in both precisions, double first
+            if ((pass == 0 && !runDouble) || (pass == 1 && !runFloat))
+                continue;
+            BenchResult r = (pass == 0) ? RunScenario<double>(*selected[i], options)
+                                        : RunScenario<float>(*selected[i], options);
+            printf("%-14s %6s %8d %7d %9.2f %11.1f %12.2f %14lld %14lld %10.1f\n",
+                   r.name.c_str(), r.precision, r.balls, r.steps, r.substepsAvg, r.stepsPerSec,
+                   r.nsPerParticleSubstep, r.pairsTested, r.contacts, r.peakRssKb / 1024.0);
+            if (r.perf)
+                PrintPerf(r);
+            fflush(stdout);
+            results.push_back(r);
+        }
+    }
+
+    if (jsonPath)
+        WriteJson(jsonPath, results, options);
+    return 0;
+}
+
+// g++ bench.cpp -o bench -O2 -mavx2 -pthread            (Windows: add -lpsapi)
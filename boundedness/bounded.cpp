@@ -1,97 +1,26 @@
 #include <stdio.h>
 #include <SDL2/SDL.h>
 #include <math.h>
+#include "../engine/world.h"
+#include "../sdl_draw.h"
 
 
 
 // Setting window height and width
 #define WIDTH 600
 #define HEIGHT 600
-#define COLOR_WHITE 0xffffffff
-#define COLOR_BLACK 0x00000000
 #define GRAVITY 0.5
 #define ELASTICITY 0.9
 
-
-// Creating a structure for Circle that takes x and y coordinates and radius
-struct Circle
+// Box walls at the window edges, fixed at compile time
+// (see engine/policies.h)
+struct Walls
 {
-    double x,y;
-
-    double oldx, oldy;
-    double radius;
+    static constexpr double width = WIDTH;
+    static constexpr double height = HEIGHT;
 };
 
-
-void FillCircle(SDL_Surface* surface, Circle circle, Uint32 color) {
-    double radiusSquared = circle.radius * circle.radius;
-    for (double x=circle.x - circle.radius; x <= circle.x + circle.radius; x++) {
-        for (double y=circle.y - circle.radius; y <= circle.y + circle.radius; y++) {
-            double distance_squared = (x - circle.x) * (x - circle.x) + (y - circle.y) * (y - circle.y);
-            if (distance_squared <= radiusSquared) {
-                SDL_Rect pixel = (SDL_Rect){(int)x, (int)y, 1, 1};
-                SDL_FillRect(surface, &pixel, color);
-            }
-        }
-    }
-}
-
-void UpdateCircle(Circle& circle)
-{
-    double dt = 1.0;
-
-    // Calculate velocity
-    // velocity = current_position - old_position
-    double vx = circle.x - circle.oldx;
-    double vy = circle.y - circle.oldy;
-
-    // Store current position
-    circle.oldx = circle.x;
-    circle.oldy = circle.y;
-
-    // Apply Verlet integration
-    // New position = current position + velocity + acceleration * dt^2
-    // Here, acceleration is due to gravity
-    circle.x += vx;
-    circle.y += vy + GRAVITY * dt * dt;
-}
-
-void ApplyConstraints(Circle& circle)
-{
-
-    // Elasticity makes the circle bounce off the walls
-    // velocity *= -e
-    // Here, we adjust the old position based on the new position and the elasticity factor
-    
-
-    // Calculate velocity
-    double vx = circle.x - circle.oldx;
-    double vy = circle.y - circle.oldy;
-
-    // Left wall
-    if (circle.x < circle.radius) {
-        circle.x = circle.radius;
-        circle.oldx = circle.x + vx * ELASTICITY;
-    }
-
-    // Right wall
-    if (circle.x > WIDTH - circle.radius) {
-        circle.x = WIDTH - circle.radius;
-        circle.oldx = circle.x + vx * ELASTICITY;
-    }
-
-    // Top wall
-    if (circle.y < circle.radius) {
-        circle.y = circle.radius;
-        circle.oldy = circle.y + vy * ELASTICITY;
-    }
-
-    // Bottom wall
-    if (circle.y > HEIGHT - circle.radius) {
-        circle.y = HEIGHT - circle.radius;
-        circle.oldy = circle.y + vy * ELASTICITY;
-    }
-}
+typedef BasicWorld<Scalar, BoxContainer<Walls> > DemoWorld;
 
 // Main function
 int main(int argc, char* argv[]) {
@@ -118,6 +47,16 @@ circle.y = 100;
 circle.oldx = 300;
 circle.oldy = 100;
 circle.radius = 40;
+circle.color = COLOR_WHITE;
+
+    // Physics world: box walls at the window edges, one constraint pass
+    // per frame (GRAVITY is px per frame^2 at 60 Hz)
+    WorldConfig config;
+    config.gravity = GRAVITY * 60.0 * 60.0;
+    config.elasticity = ELASTICITY;
+    config.substeps = 1;
+    DemoWorld world(config);
+    world.particles().push_back(circle);
 
 
 
@@ -137,9 +76,9 @@ circle.radius = 40;
         }
         // Clear the surface
         SDL_FillRect(surface, NULL, COLOR_BLACK);
-    UpdateCircle(circle);
-    ApplyConstraints(circle);
-    FillCircle(surface, circle, COLOR_WHITE);
+    // Integrate, then keep the circle inside the walls
+    world.step(1.0 / 60.0);
+    DrawBalls(surface, world.particles());
         SDL_UpdateWindowSurface(window);
 
 
@@ -154,4 +93,4 @@ circle.radius = 40;
 
 
 
-// g++ gravity.cpp -o gravity -I C:/MinGW/include -L C:/MinGW/lib -lmingw32 -lSDL2main -lSDL2 -lm
\ No newline at end of file
+// g++ bounded.cpp -o bounded -I C:/MinGW/include -L C:/MinGW/lib -lmingw32 -lSDL2main -lSDL2 -lm -O2 -mavx2 -pthread
\ No newline at end of file
@@ -1,194 +1,26 @@
 #include <stdio.h>
 #include <SDL2/SDL.h>
 #include <math.h>
+#include "engine/world.h"
+#include "sdl_draw.h"
 
 // Window size
 #define WIDTH 600
 #define HEIGHT 600
 
-// Colors
-#define COLOR_WHITE 0xffffffff
-#define COLOR_BLACK 0x00000000
-
 // Physics constants
 #define GRAVITY 0.5
 #define ELASTICITY 0.9   // 1.0 = perfectly elastic
 
-// ----------------------------
-// Circle structure
-// ----------------------------
-// x, y       -> current position
-// oldx, oldy -> previous position (used to infer velocity)
-// radius     -> circle size
-struct Circle
+// Container circle, fixed at compile time (see engine/policies.h)
+struct Container
 {
-    double x, y;
-    double oldx, oldy;
-    double radius;
+    static constexpr double x = WIDTH / 2;
+    static constexpr double y = HEIGHT / 2;
+    static constexpr double radius = 250;
 };
 
-// ----------------------------
-// Filled circle rendering
-// ----------------------------
-void FillCircle(SDL_Surface* surface, Circle circle, Uint32 color)
-{
-    double r2 = circle.radius * circle.radius;
-
-    for (int x = circle.x - circle.radius; x <= circle.x + circle.radius; x++) {
-        for (int y = circle.y - circle.radius; y <= circle.y + circle.radius; y++) {
-            double dx = x - circle.x;
-            double dy = y - circle.y;
-            if (dx*dx + dy*dy <= r2) {
-                SDL_Rect pixel = { x, y, 1, 1 };
-                SDL_FillRect(surface, &pixel, color);
-            }
-        }
-    }
-}
-
-// ----------------------------
-// Draw outline of container circle
-// ----------------------------
-void DrawCircleOutline(SDL_Surface* surface, Circle circle, Uint32 color)
-{
-    double rOuter = circle.radius * circle.radius;
-    double rInner = (circle.radius - 1) * (circle.radius - 1);
-
-    for (int x = circle.x - circle.radius; x <= circle.x + circle.radius; x++) {
-        for (int y = circle.y - circle.radius; y <= circle.y + circle.radius; y++) {
-            double dx = x - circle.x;
-            double dy = y - circle.y;
-            double d = dx*dx + dy*dy;
-            if (d <= rOuter && d >= rInner) {
-                SDL_Rect pixel = { x, y, 1, 1 };
-                SDL_FillRect(surface, &pixel, color);
-            }
-        }
-    }
-}
-
-// ----------------------------
-// Verlet integration step
-// ----------------------------
-void UpdateCircle(Circle& c)
-{
-    double vx = c.x - c.oldx;
-    double vy = c.y - c.oldy;
-
-    // Store current position
-    c.oldx = c.x;
-    c.oldy = c.y;
-
-    // Integrate position (gravity acts downward)
-    c.x += vx;
-    c.y += vy + GRAVITY;
-}
-
-// ----------------------------
-// Circular container constraint
-// ----------------------------
-void ApplyCircularConstraint(Circle& particle, const Circle& container)
-{
-    // Capture velocity FIRST (before modifying position)
-    double vx = particle.x - particle.oldx;
-    double vy = particle.y - particle.oldy;
-
-    // Vector from container center to particle
-    double dx = particle.x - container.x;
-    double dy = particle.y - container.y;
-
-    double dist = sqrt(dx*dx + dy*dy);
-    double maxDist = container.radius - particle.radius;
-
-    // If particle escapes container
-    if (dist > maxDist) {
-        // Normal vector
-        double nx = dx / dist;
-        double ny = dy / dist;
-
-        // Snap particle back onto boundary
-        particle.x = container.x + nx * maxDist;
-        particle.y = container.y + ny * maxDist;
-
-        // Reflect velocity across normal
-        double dot = vx * nx + vy * ny;
-        vx -= 2.0 * dot * nx;
-        vy -= 2.0 * dot * ny;
-
-        // Apply elasticity
-        vx *= ELASTICITY;
-        vy *= ELASTICITY;
-
-        // Reconstruct previous position
-        particle.oldx = particle.x - vx;
-        particle.oldy = particle.y - vy;
-    }
-}
-
-
-// Applying Collisions
-void ResolveBallCollision(Circle& a, Circle& b)
-{
-    // Vector between centers
-    double dx = b.x - a.x;
-    double dy = b.y - a.y;
-
-    double dist = sqrt(dx*dx + dy*dy);
-    double minDist = a.radius + b.radius;
-
-    // No collision
-    if (dist >= minDist || dist == 0.0)
-        return;
-
-    // Normalized collision normal
-    double nx = dx / dist;
-    double ny = dy / dist;
-
-    // -------- POSITION CORRECTION --------
-    double overlap = minDist - dist;
-    double correction = overlap * 0.5;
-
-    a.x -= nx * correction;
-    a.y -= ny * correction;
-    b.x += nx * correction;
-    b.y += ny * correction;
-
-    // -------- VELOCITY (VERLET STYLE) --------
-    double avx = a.x - a.oldx;
-    double avy = a.y - a.oldy;
-    double bvx = b.x - b.oldx;
-    double bvy = b.y - b.oldy;
-
-    // Relative velocity
-    double rvx = bvx - avx;
-    double rvy = bvy - avy;
-
-    // Velocity along normal
-    double velAlongNormal = rvx * nx + rvy * ny;
-
-    // If balls are separating, don't resolve
-    if (velAlongNormal > 0)
-        return;
-
-    // Elastic response
-    double impulse = -(1.0 + ELASTICITY) * velAlongNormal;
-    impulse *= 0.5; // equal mass
-
-    double ix = impulse * nx;
-    double iy = impulse * ny;
-
-    avx -= ix;
-    avy -= iy;
-    bvx += ix;
-    bvy += iy;
-
-    // Reconstruct old positions
-    a.oldx = a.x - avx;
-    a.oldy = a.y - avy;
-    b.oldx = b.x - bvx;
-    b.oldy = b.y - bvy;
-}
-
+typedef BasicWorld<Scalar, CircleContainer<Container> > DemoWorld;
 
 // ----------------------------
 // Main
@@ -209,9 +41,16 @@ int main(int argc, char* argv[])
 
     // Container circle
     Circle container;
-    container.x = WIDTH / 2;
-    container.y = HEIGHT / 2;
-    container.radius = 250;
+    container.x = Container::x;
+    container.y = Container::y;
+    container.radius = Container::radius;
+
+    // Physics world (GRAVITY is px per frame^2 at 60 Hz)
+    WorldConfig config;
+    config.gravity = GRAVITY * 60.0 * 60.0;
+    config.elasticity = ELASTICITY;
+    config.substeps = 4;
+    DemoWorld world(config);
 
     // Particle
     Circle ball;
@@ -228,6 +67,11 @@ ball2.oldx = 350;
 ball2.oldy = 100;
 ball2.radius = 40;
 
+    ball.color = COLOR_WHITE;
+    ball2.color = COLOR_WHITE;
+    world.particles().push_back(ball);
+    world.particles().push_back(ball2);
+
 
     int running = 1;
     SDL_Event event;
@@ -242,19 +86,11 @@ ball2.radius = 40;
 
         SDL_FillRect(surface, NULL, COLOR_BLACK);
 
-        UpdateCircle(ball);
-        UpdateCircle(ball2);
-
-        // Solve constraints & collisions multiple times
-        for (int i = 0; i < 4; i++) {
-            ApplyCircularConstraint(ball, container);
-            ApplyCircularConstraint(ball2, container);
-            ResolveBallCollision(ball, ball2);
-        }
+        // Integrate, then 4 rounds of collisions + constraint
+        world.step(1.0 / 60.0);
 
         // Render
-        FillCircle(surface, ball, COLOR_WHITE);
-        FillCircle(surface, ball2, COLOR_WHITE);
+        DrawBalls(surface, world.particles());
         DrawCircleOutline(surface, container, COLOR_WHITE);
 
         SDL_UpdateWindowSurface(window);
@@ -265,4 +101,4 @@ ball2.radius = 40;
     return 0;
 }
 
-// g++ collision.cpp -o collision -I C:/MinGW/include -L C:/MinGW/lib -lmingw32 -lSDL2main -lSDL2 -lm
\ No newline at end of file
+// g++ collision.cpp -o collision -I C:/MinGW/include -L C:/MinGW/lib -lmingw32 -lSDL2main -lSDL2 -lm -O2 -mavx2 -pthread
\ No newline at end of file
@@ -1,211 +1,30 @@
 #include <stdio.h>
-#include <vector>
 #include <SDL2/SDL.h>
 #include <math.h>
+#include "engine/world.h"
+#include "sdl_draw.h"
 
 // Window size
 #define WIDTH 600
 #define HEIGHT 600
 
-// Colors
-#define COLOR_WHITE 0xffffffff
-#define COLOR_BLACK 0x00000000
-
 // Physics constants
 #define GRAVITY 0.5
 #define ELASTICITY 0.9   // 1.0 = perfectly elastic
 #define BALL_COUNT 300
 #define SUBSTEP_COUNT 8
-// ----------------------------
-// Circle structure
-// ----------------------------
-// x, y       -> current position
-// oldx, oldy -> previous position (used to infer velocity)
-// radius     -> circle size
-struct Circle
-{
-    double x, y;
-    double oldx, oldy;
-    double radius;
-    Uint32 color;
-};
-
-Uint32 getRainbow(SDL_Surface* surface, float t)
-{
-    float r = sinf(t);
-    float g = sinf(t + 0.33f * 2.0f * M_PI);
-    float b = sinf(t + 0.66f * 2.0f * M_PI);
-
-    Uint8 R = (Uint8)(255.0f * r * r);
-    Uint8 G = (Uint8)(255.0f * g * g);
-    Uint8 B = (Uint8)(255.0f * b * b);
-
-    return SDL_MapRGB(surface->format, R, G, B);
-}
-
-
-// ----------------------------
-// Filled circle rendering
-// ----------------------------
-void FillCircle(SDL_Surface* surface, Circle circle, Uint32 color)
-{
-    double r2 = circle.radius * circle.radius;
-
-    for (int x = circle.x - circle.radius; x <= circle.x + circle.radius; x++) {
-        for (int y = circle.y - circle.radius; y <= circle.y + circle.radius; y++) {
-            double dx = x - circle.x;
-            double dy = y - circle.y;
-            if (dx*dx + dy*dy <= r2) {
-                SDL_Rect pixel = { x, y, 1, 1 };
-                SDL_FillRect(surface, &pixel, color);
-            }
-        }
-    }
-}
-
-// ----------------------------
-// Draw outline of container circle
-// ----------------------------
-void DrawCircleOutline(SDL_Surface* surface, Circle circle, Uint32 color)
-{
-    double rOuter = circle.radius * circle.radius;
-    double rInner = (circle.radius - 1) * (circle.radius - 1);
-
-    for (int x = circle.x - circle.radius; x <= circle.x + circle.radius; x++) {
-        for (int y = circle.y - circle.radius; y <= circle.y + circle.radius; y++) {
-            double dx = x - circle.x;
-            double dy = y - circle.y;
-            double d = dx*dx + dy*dy;
-            if (d <= rOuter && d >= rInner) {
-                SDL_Rect pixel = { x, y, 1, 1 };
-                SDL_FillRect(surface, &pixel, color);
-            }
-        }
-    }
-}
-
-// ----------------------------
-// Verlet integration step
-// ----------------------------
-void UpdateCircle(Circle& c)
-{
-    double vx = c.x - c.oldx;
-    double vy = c.y - c.oldy;
-
-    // Store current position
-    c.oldx = c.x;
-    c.oldy = c.y;
-
-    // Integrate position (gravity acts downward)
-    c.x += vx;
-    c.y += vy + GRAVITY;
-}
+#define USE_BRUTE_FORCE 0   // 1 = test every pair (reference path)
+#define USE_SLEEPING 1      // 1 = freeze piles that have come to rest
 
-// ----------------------------
-// Circular container constraint
-// ----------------------------
-void ApplyCircularConstraint(Circle& particle, const Circle& container)
+// Container circle, fixed at compile time (see engine/policies.h)
+struct Container
 {
-    // Capture velocity FIRST (before modifying position)
-    double vx = particle.x - particle.oldx;
-    double vy = particle.y - particle.oldy;
-
-    // Vector from container center to particle
-    double dx = particle.x - container.x;
-    double dy = particle.y - container.y;
-
-    double dist = sqrt(dx*dx + dy*dy);
-    double maxDist = container.radius - particle.radius;
-
-    // If particle escapes container
-    if (dist > maxDist) {
-        // Normal vector
-        double nx = dx / dist;
-        double ny = dy / dist;
-
-        // Snap particle back onto boundary
-        particle.x = container.x + nx * maxDist;
-        particle.y = container.y + ny * maxDist;
-
-        // Reflect velocity across normal
-        double dot = vx * nx + vy * ny;
-        vx -= 2.0 * dot * nx;
-        vy -= 2.0 * dot * ny;
-
-        // Apply elasticity
-        vx *= ELASTICITY;
-        vy *= ELASTICITY;
-
-        // Reconstruct previous position
-        particle.oldx = particle.x - vx;
-        particle.oldy = particle.y - vy;
-    }
-}
-
-
-// Applying Collisions
-void ResolveBallCollision(Circle& a, Circle& b)
-{
-    // Vector between centers
-    double dx = b.x - a.x;
-    double dy = b.y - a.y;
-
-    double dist = sqrt(dx*dx + dy*dy);
-    double minDist = a.radius + b.radius;
-
-    // No collision
-    if (dist >= minDist || dist == 0.0)
-        return;
-
-    // Normalized collision normal
-    double nx = dx / dist;
-    double ny = dy / dist;
-
-    // -------- POSITION CORRECTION --------
-    double overlap = minDist - dist;
-    double correction = overlap * 0.5;
-
-    a.x -= nx * correction;
-    a.y -= ny * correction;
-    b.x += nx * correction;
-    b.y += ny * correction;
-
-    // -------- VELOCITY (VERLET STYLE) --------
-    double avx = a.x - a.oldx;
-    double avy = a.y - a.oldy;
-    double bvx = b.x - b.oldx;
-    double bvy = b.y - b.oldy;
-
-    // Relative velocity
-    double rvx = bvx - avx;
-    double rvy = bvy - avy;
-
-    // Velocity along normal
-    double velAlongNormal = rvx * nx + rvy * ny;
-
-    // If balls are separating, don't resolve
-    if (velAlongNormal > 0)
-        return;
-
-    // Elastic response
-    double impulse = -(1.0 + ELASTICITY) * velAlongNormal;
-    impulse *= 0.5; // equal mass
-
-    double ix = impulse * nx;
-    double iy = impulse * ny;
-
-    avx -= ix;
-    avy -= iy;
-    bvx += ix;
-    bvy += iy;
-
-    // Reconstruct old positions
-    a.oldx = a.x - avx;
-    a.oldy = a.y - avy;
-    b.oldx = b.x - bvx;
-    b.oldy = b.y - bvy;
-}
+    static constexpr double x = WIDTH / 2;
+    static constexpr double y = HEIGHT / 2;
+    static constexpr double radius = 250;
+};
 
+typedef BasicWorld<Scalar, CircleContainer<Container> > DemoWorld;
 
 // ----------------------------
 // Main
@@ -226,9 +45,18 @@ int main(int argc, char* argv[])
 
     // Container circle
     Circle container;
-    container.x = WIDTH / 2;
-    container.y = HEIGHT / 2;
-    container.radius = 250;
+    container.x = Container::x;
+    container.y = Container::y;
+    container.radius = Container::radius;
+
+    // Physics world (GRAVITY is px per frame^2 at 60 Hz)
+    WorldConfig config;
+    config.gravity = GRAVITY * 60.0 * 60.0;
+    config.elasticity = ELASTICITY;
+    config.substeps = SUBSTEP_COUNT;
+    config.bruteForce = USE_BRUTE_FORCE;
+    config.sleeping = USE_SLEEPING;
+    DemoWorld world(config);
 
     // Particle
 //     Circle ball;
@@ -239,10 +67,9 @@ int main(int argc, char* argv[])
 //     ball.radius = 40;
 
 
-    std::vector<Circle> balls;
-    // Vector - used to store multiple balls if needed
-    // <Circle> - template for Circle structure
-    // balls - name of the vector
+    ParticleStore& balls = world.particles();
+    // Structure of arrays - positions, old positions and radii each live
+    // in their own array, colors in a side table (see engine/particle_store.h)
 float colorTime = 0.0f;
 float colorStep = 0.15f; // smaller = smoother rainbow
 
@@ -274,28 +101,11 @@ for (int i = 0; i < BALL_COUNT; i++) {
 
         SDL_FillRect(surface, NULL, COLOR_BLACK);
 
-            for (int i = 0; i < balls.size(); i++) {
-        UpdateCircle(balls[i]);
-    } // Update all balls
-        
-
-        // Solve constraints & collisions multiple times
-        // SUB-STEPPING FOR STABILITY
-        for (int i = 0; i < SUBSTEP_COUNT; i++) {
-            for (int i = 0; i < balls.size(); i++) {
-                for (int j = i + 1; j < balls.size(); j++) {
-                    ResolveBallCollision(balls[i], balls[j]);
-                }
-            ApplyCircularConstraint(balls[i], container);
-            }
-        }
-
-
+        // Integrate, then SUBSTEP_COUNT rounds of collisions + constraint
+        world.step(1.0 / 60.0);
 
         // Render
-        for (int i = 0; i < balls.size(); i++) {
-    FillCircle(surface, balls[i], balls[i].color);
-}
+        DrawBalls(surface, balls);
         DrawCircleOutline(surface, container, COLOR_WHITE);
 
         SDL_UpdateWindowSurface(window);
@@ -306,4 +116,4 @@ for (int i = 0; i < BALL_COUNT; i++) {
     return 0;
 }
 
-// g++ n_collision.cpp -o n_collision -I C:/MinGW/include -L C:/MinGW/lib -lmingw32 -lSDL2main -lSDL2 -lm
\ No newline at end of file
+// g++ n_collision.cpp -o n_collision -I C:/MinGW/include -L C:/MinGW/lib -lmingw32 -lSDL2main -lSDL2 -lm -O2 -mavx2 -pthread
\ No newline at end of file
@@ -0,0 +1,330 @@
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+#include <vector>
+#include "particle_store.h"
+#include "spatial_grid.h"
+#include "policies.h"
+
+// ----------------------------
+// Continuous collision detection
+// ----------------------------
+// The discrete solver only sees where balls are after the Verlet step. A
+// small ball moving more than its radius per step can end up on the far
+// side of another ball (or of the container wall) without ever overlapping
+// it, which is why the demos need 8 substeps.
+//
+// After integration each ball moved in a straight line from (oldx, oldy) to
+// (x, y). For balls moving faster than threshold * radius per step that
+// path is swept against every ball it could reach and against the
+// container; at the earliest time of impact both balls are put back where
+// they touch and get the same elastic response as ResolveBallCollision.
+// The rest of the step's motion is dropped, as the discrete solver drops
+// the overlap it corrects. Slow balls are left to the discrete solver.
+//
+// Runs serially in ball order (fast balls are few), so results do not
+// depend on the thread count.
+
+// Earliest t in [0, 1] at which two circles whose centers are (dx, dy)
+// apart and approach with relative motion (dvx, dvy) per step are minDist
+// apart. False if they never touch in this step, or already overlap at
+// t = 0 (the discrete solver's job).
+template <typename T>
+inline bool SweptCircleCircle(T dx, T dy, T dvx, T dvy, T minDist, T& t)
+{
+    T c = dx * dx + dy * dy - minDist * minDist;
+    T b = dx * dvx + dy * dvy;
+    if (c <= 0 || b >= 0)
+        return false;
+    T a = dvx * dvx + dvy * dvy;
+    T disc = b * b - a * c;
+    if (disc < 0)
+        return false;
+    t = (-b - sqrt(disc)) / a;
+    return t <= 1;
+}
+
+// Time t in [0, 1] at which a center moving from (px, py) by (vx, vy),
+// relative to the container center, reaches distance limit from it
+// (limit = container radius - ball radius). False if it stays inside.
+template <typename T>
+inline bool SweptCircleContainer(T px, T py, T vx, T vy, T limit, T& t)
+{
+    T ex = px + vx, ey = py + vy;
+    if (limit <= 0 || ex * ex + ey * ey <= limit * limit)
+        return false;
+    T a = vx * vx + vy * vy;
+    T b = px * vx + py * vy;
+    T c = px * px + py * py - limit * limit;
+    T disc = b * b - a * c;
+
+    // Started on or outside the wall and never comes in: hit right away.
+    // Otherwise the impact is where the path leaves the circle (a ball
+    // bouncing off the wall starts on it, heading in).
+    if ((c >= 0 && b >= 0) || disc < 0) {
+        t = 0;
+        return true;
+    }
+    t = (-b + sqrt(disc)) / a;
+    return true;
+}
+
+// ----------------------------
+// Container time of impact
+// ----------------------------
+// Swept test of ball i against the constraint policy, as (time, container
+// center, limit). Circles are the only shape that needs it: a ball can
+// leave a circle between two steps and be projected back onto the wrong
+// side, while box walls are half-planes the discrete clamp already handles.
+// Other policies get no swept test.
+template <typename Constraint, typename T>
+inline bool ContainerImpact(const Constraint&, const BasicParticleStore<T>&, int, T&, T&, T&, T&)
+{
+    return false;
+}
+
+template <typename T>
+inline bool CircleImpact(const BasicParticleStore<T>& p, int i, T cx, T cy, T cr,
+                         T& t, T& outCx, T& outCy, T& limit)
+{
+    limit = cr - p.radius[i];
+    outCx = cx;
+    outCy = cy;
+    return SweptCircleContainer(p.oldx[i] - cx, p.oldy[i] - cy,
+                                p.x[i] - p.oldx[i], p.y[i] - p.oldy[i], limit, t);
+}
+
+template <typename T>
+inline bool ContainerImpact(const ConfigContainer& c, const BasicParticleStore<T>& p, int i,
+                            T& t, T& cx, T& cy, T& limit)
+{
+    if (c.shape != CONTAINER_CIRCLE)
+        return false;
+    return CircleImpact(p, i, (T)c.x, (T)c.y, (T)c.radius, t, cx, cy, limit);
+}
+
+template <typename Shape, typename T>
+inline bool ContainerImpact(const CircleContainer<Shape>&, const BasicParticleStore<T>& p, int i,
+                            T& t, T& cx, T& cy, T& limit)
+{
+    return CircleImpact(p, i, (T)Shape::x, (T)Shape::y, (T)Shape::radius, t, cx, cy, limit);
+}
+
+// ----------------------------
+// Swept pass over the fast balls
+// ----------------------------
+#define SWEEP_GRID_CELLS 4      // motion per step up to which sweeps search the grid
+
+struct SweptCollisions
+{
+    // Statistics of the last Run
+    int fastBalls = 0;
+    int impacts = 0;
+    int ballImpacts = 0;        // of those, against another ball
+
+    // Bins the balls into grid (only if some ball is fast, so calm steps
+    // cost one pass over the velocities). Sleeping balls that get hit are
+    // flagged in wake (if given). With balls = false (ball-ball collisions
+    // off) only the container is swept. Returns the number of impacts
+    // resolved.
+    template <typename T, typename Constraint>
+    int Run(BasicParticleStore<T>& p, SpatialGrid& grid, const Constraint& container,
+            T elasticity, double threshold, bool balls = true, uint8_t* wake = nullptr)
+    {
+        int n = p.size();
+        fastBalls = 0;
+        impacts = 0;
+        ballImpacts = 0;
+
+        fast.clear();
+        for (int i = 0; i < n; i++) {
+            T vx = p.x[i] - p.oldx[i];
+            T vy = p.y[i] - p.oldy[i];
+            T limit = (T)threshold * p.radius[i];
+            if (vx * vx + vy * vy > limit * limit)
+                fast.push_back(i);
+        }
+        fastBalls = (int)fast.size();
+        if (fast.empty())
+            return 0;
+
+        // Container only: every fast ball on its own
+        if (!balls) {
+            for (size_t f = 0; f < fast.size(); f++) {
+                int a = fast[f];
+                T t, cx, cy, limit;
+                if (ContainerImpact(container, p, a, t, cx, cy, limit) && t <= 1) {
+                    HitContainer(p, a, t, cx, cy, limit, elasticity);
+                    impacts++;
+                }
+            }
+            return impacts;
+        }
+
+        grid.Build(p);
+
+        // How far any ball's path can reach from where the grid has it.
+        // Balls moving more than SWEEP_GRID_CELLS cells per step are "far
+        // movers", tested against every fast ball explicitly, so one stray
+        // ball does not blow up every sweep's search box.
+        farMovers.clear();
+        kind.assign(n, 0);
+        double maxRadius = 0.0, maxMotion = 0.0;
+        double farMotion = SWEEP_GRID_CELLS * grid.cellSize;
+        for (int i = 0; i < n; i++) {
+            double vx = p.x[i] - p.oldx[i];
+            double vy = p.y[i] - p.oldy[i];
+            double motion2 = vx * vx + vy * vy;
+            if (motion2 > farMotion * farMotion) {
+                farMovers.push_back(i);
+                kind[i] |= KIND_FAR;
+            } else if (motion2 > maxMotion * maxMotion) {
+                maxMotion = sqrt(motion2);
+            }
+            if (p.radius[i] > maxRadius)
+                maxRadius = p.radius[i];
+        }
+
+        for (size_t f = 0; f < fast.size(); f++) {
+            int a = fast[f];
+            if (kind[a] & KIND_DONE)
+                continue;
+
+            T ax = p.oldx[a], ay = p.oldy[a];
+            T avx = p.x[a] - ax, avy = p.y[a] - ay;
+
+            // Earliest impact: the container, then every ball in reach
+            T best = 2;
+            int other = -1;
+            T cx = 0, cy = 0, limit = 0, t;
+            if (ContainerImpact(container, p, a, t, cx, cy, limit))
+                best = t;
+
+            auto test = [&](int b) {
+                if (b == a)
+                    return;
+                T bx, by, bvx, bvy;
+                Motion(p, b, bx, by, bvx, bvy);
+                T tb;
+                if (SweptCircleCircle(bx - ax, by - ay, bvx - avx, bvy - avy,
+                                      p.radius[a] + p.radius[b], tb) && tb < best) {
+                    best = tb;
+                    other = b;
+                }
+            };
+
+            // Any other ball touching the sweep ends within this box
+            double reach = p.radius[a] + maxRadius + maxMotion;
+            double x0 = ax < p.x[a] ? ax : p.x[a], x1 = ax < p.x[a] ? p.x[a] : ax;
+            double y0 = ay < p.y[a] ? ay : p.y[a], y1 = ay < p.y[a] ? p.y[a] : ay;
+            int c0 = grid.CellIndex(x0 - reach, y0 - reach);
+            int c1 = grid.CellIndex(x1 + reach, y1 + reach);
+            for (int gy = c0 / grid.cols; gy <= c1 / grid.cols; gy++) {
+                for (int gx = c0 % grid.cols; gx <= c1 % grid.cols; gx++) {
+                    int cell = gy * grid.cols + gx;
+                    for (int k = grid.cellStart[cell]; k < grid.cellStart[cell + 1]; k++) {
+                        int b = grid.cellItems[k];
+                        if (!(kind[b] & KIND_FAR))
+                            test(b);
+                    }
+                }
+            }
+            for (size_t g = 0; g < farMovers.size(); g++)
+                test(farMovers[g]);
+
+            if (best > 1)
+                continue;
+
+            if (other < 0) {
+                HitContainer(p, a, best, cx, cy, limit, elasticity);
+            } else {
+                HitBall(p, a, other, best, elasticity);
+                ballImpacts++;
+                kind[other] |= KIND_DONE;
+                if (wake && p.sleeping[other])
+                    wake[other] = 1;
+            }
+            kind[a] |= KIND_DONE;
+            impacts++;
+        }
+        return impacts;
+    }
+
+private:
+    enum { KIND_FAR = 1, KIND_DONE = 2 };
+
+    std::vector<int> fast;
+    std::vector<int> farMovers;
+    std::vector<uint8_t> kind;  // KIND_* flags per ball
+
+    // Start and motion of ball b this step; balls already put back at an
+    // impact stand still where they are
+    template <typename T>
+    void Motion(const BasicParticleStore<T>& p, int b, T& x, T& y, T& vx, T& vy) const
+    {
+        if (kind[b] & KIND_DONE) {
+            x = p.x[b]; y = p.y[b];
+            vx = 0; vy = 0;
+            return;
+        }
+        x = p.oldx[b]; y = p.oldy[b];
+        vx = p.x[b] - x; vy = p.y[b] - y;
+    }
+
+    // Both balls at their positions at time t, then the equal-mass elastic
+    // response of ResolveBallCollision
+    template <typename T>
+    void HitBall(BasicParticleStore<T>& p, int a, int b, T t, T elasticity) const
+    {
+        T ax, ay, avx, avy, bx, by, bvx, bvy;
+        Motion(p, a, ax, ay, avx, avy);
+        Motion(p, b, bx, by, bvx, bvy);
+        ax += avx * t; ay += avy * t;
+        bx += bvx * t; by += bvy * t;
+
+        T dx = bx - ax, dy = by - ay;
+        T dist = sqrt(dx * dx + dy * dy);
+        if (dist > 0) {
+            T nx = dx / dist, ny = dy / dist;
+            T velAlongNormal = (bvx - avx) * nx + (bvy - avy) * ny;
+            if (velAlongNormal < 0) {
+                T impulse = -(1 + elasticity) * velAlongNormal * T(0.5);
+                avx -= impulse * nx; avy -= impulse * ny;
+                bvx += impulse * nx; bvy += impulse * ny;
+            }
+        }
+
+        p.x[a] = ax; p.y[a] = ay;
+        p.oldx[a] = ax - avx; p.oldy[a] = ay - avy;
+        p.x[b] = bx; p.y[b] = by;
+        p.oldx[b] = bx - bvx; p.oldy[b] = by - bvy;
+    }
+
+    // Ball on the container wall at time t, velocity reflected as in
+    // ApplyCircularConstraint
+    template <typename T>
+    static void HitContainer(BasicParticleStore<T>& p, int a, T t, T cx, T cy, T limit, T elasticity)
+    {
+        T vx = p.x[a] - p.oldx[a];
+        T vy = p.y[a] - p.oldy[a];
+        T px = p.oldx[a] + vx * t - cx;
+        T py = p.oldy[a] + vy * t - cy;
+        T dist = sqrt(px * px + py * py);
+        if (dist == 0)
+            return;
+        T nx = px / dist, ny = py / dist;
+
+        // A hair inside the wall, so rounding cannot leave it outside and
+        // have the discrete constraint reflect the velocity a second time
+        T inside = limit * T(1 - 1e-5);
+        p.x[a] = cx + nx * inside;
+        p.y[a] = cy + ny * inside;
+
+        T dot = vx * nx + vy * ny;
+        vx = (vx - 2 * dot * nx) * elasticity;
+        vy = (vy - 2 * dot * ny) * elasticity;
+        p.oldx[a] = p.x[a] - vx;
+        p.oldy[a] = p.y[a] - vy;
+    }
+};
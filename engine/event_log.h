@@ -0,0 +1,298 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// ----------------------------
+// Asynchronous event log
+// ----------------------------
+// The logging thread only copies a small binary record (time, level, format
+// pointer, up to LOG_MAX_ARGS numbers or static strings) into a lock-free
+// ring buffer. A drain thread turns the records into text and does the
+// actual I/O, so the hot loop never waits on the terminal or the disk.
+//
+//     EventLog log;                      // drains to stdout
+//     log.OpenFile("events.log");        // ...or to a file
+//     LOG_INFO(log, "Ball %d removed", i);
+//
+// One producer thread per EventLog (single-producer ring). If the ring is
+// full the record is dropped and counted, never waited for.
+//
+// Format strings and %s arguments must outlive the log (string literals).
+//
+// Levels below EVENT_LOG_LEVEL compile to nothing, arguments included:
+//
+//     g++ ... -DEVENT_LOG_LEVEL=LOG_LEVEL_WARN
+
+#define LOG_LEVEL_DEBUG 0
+#define LOG_LEVEL_INFO  1
+#define LOG_LEVEL_WARN  2
+#define LOG_LEVEL_ERROR 3
+#define LOG_LEVEL_OFF   4
+
+#ifndef EVENT_LOG_LEVEL
+#define EVENT_LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+#define LOG_MAX_ARGS 4
+
+struct LogArg
+{
+    enum Type { INT, DOUBLE, STRING } type;
+    union {
+        long long i;
+        double d;
+        const char* s;
+    };
+};
+
+struct LogRecord
+{
+    uint64_t timeNs;        // since the log was created
+    int level;
+    const char* format;
+    int argCount;
+    LogArg args[LOG_MAX_ARGS];
+};
+
+class EventLog
+{
+public:
+    // capacity is rounded up to a power of two
+    explicit EventLog(int capacity = 4096)
+    {
+        int size = 1;
+        while (size < capacity)
+            size *= 2;
+        ring.resize(size);
+        mask = size - 1;
+
+        start = std::chrono::steady_clock::now();
+        output = stdout;
+        drainThread = std::thread([this]() { DrainLoop(); });
+    }
+
+    ~EventLog()
+    {
+        running.store(false);
+        drainThread.join();
+        Drain();
+        if (ownsOutput)
+            fclose(output);
+    }
+
+    // Sends everything logged from now on to a file instead of stdout
+    bool OpenFile(const char* path)
+    {
+        FILE* f = fopen(path, "w");
+        if (!f)
+            return false;
+        FILE* old = output.exchange(f);
+        bool ownedOld = ownsOutput;
+        ownsOutput = true;
+
+        // The drain thread may still be writing to the old stream
+        std::lock_guard<std::mutex> lock(outputMutex);
+        if (ownedOld)
+            fclose(old);
+        else
+            fflush(old);
+        return true;
+    }
+
+    // Records lost because the ring was full
+    long long Dropped() const { return dropped.load(std::memory_order_relaxed); }
+
+    // Producer side. Never blocks; returns false if the record was dropped.
+    template <typename... Args>
+    bool Write(int level, const char* format, Args... args)
+    {
+        static_assert(sizeof...(Args) <= LOG_MAX_ARGS, "too many log arguments");
+
+        uint64_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) > mask) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        LogRecord& r = ring[h & mask];
+        r.timeNs = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        r.level = level;
+        r.format = format;
+        r.argCount = 0;
+        Pack(r, args...);
+
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    std::vector<LogRecord> ring;
+    uint64_t mask = 0;
+    std::atomic<uint64_t> head{0};      // next record to write (producer)
+    std::atomic<uint64_t> tail{0};      // next record to read (drain thread)
+    std::atomic<long long> dropped{0};
+
+    std::chrono::steady_clock::time_point start;
+    std::atomic<FILE*> output;
+    bool ownsOutput = false;
+    std::mutex outputMutex;             // only between the drain and OpenFile
+
+    std::atomic<bool> running{true};
+    std::thread drainThread;
+
+    // Argument packing: integers, floating point and static strings
+    static void Pack(LogRecord&) {}
+
+    template <typename T, typename... Rest>
+    static void Pack(LogRecord& r, T v, Rest... rest)
+    {
+        LogArg& a = r.args[r.argCount++];
+        if constexpr (std::is_integral<T>::value || std::is_enum<T>::value) {
+            a.type = LogArg::INT;
+            a.i = (long long)v;
+        } else if constexpr (std::is_floating_point<T>::value) {
+            a.type = LogArg::DOUBLE;
+            a.d = (double)v;
+        } else {
+            static_assert(std::is_convertible<T, const char*>::value, "unsupported log argument");
+            a.type = LogArg::STRING;
+            a.s = v;
+        }
+        Pack(r, rest...);
+    }
+
+    void DrainLoop()
+    {
+        while (running.load()) {
+            if (!Drain())
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+    }
+
+    // Formats and writes every pending record. Returns false if there was none.
+    bool Drain()
+    {
+        uint64_t t = tail.load(std::memory_order_relaxed);
+        uint64_t h = head.load(std::memory_order_acquire);
+        if (t == h)
+            return false;
+
+        std::lock_guard<std::mutex> lock(outputMutex);
+        FILE* out = output.load();
+        char line[512];
+        for (; t != h; t++) {
+            Format(ring[t & mask], line, sizeof(line));
+            fputs(line, out);
+            // Free the slot as soon as it is formatted
+            tail.store(t + 1, std::memory_order_release);
+        }
+        fflush(out);
+        return true;
+    }
+
+    static const char* LevelName(int level)
+    {
+        static const char* names[] = { "DEBUG", "INFO", "WARN", "ERROR" };
+        return (level >= 0 && level < 4) ? names[level] : "?";
+    }
+
+    // printf-style formatting of a record: each conversion is handed to
+    // snprintf on its own with the stored argument
+    static void Format(const LogRecord& r, char* line, int size)
+    {
+        int used = snprintf(line, size, "[%10.3f ms] %-5s ", r.timeNs / 1e6, LevelName(r.level));
+        int arg = 0;
+        const char* f = r.format;
+
+        while (*f && used < size - 1) {
+            if (*f != '%') {
+                line[used++] = *f++;
+                continue;
+            }
+            if (f[1] == '%') {
+                line[used++] = '%';
+                f += 2;
+                continue;
+            }
+
+            // One conversion: %[flags][width][.precision][length]type
+            char spec[32];
+            int n = 0;
+            spec[n++] = *f++;
+            while (*f && strchr("-+ #0123456789.", *f) && n < 24)
+                spec[n++] = *f++;
+            while (*f && strchr("hlLqjzt", *f))
+                f++;    // length modifiers are replaced below
+            char type = *f ? *f++ : 'd';
+
+            const LogArg* a = (arg < r.argCount) ? &r.args[arg++] : nullptr;
+            int written = 0;
+            if (!a) {
+                written = snprintf(line + used, size - used, "<?>");
+            } else if (strchr("diouxX", type)) {
+                spec[n++] = 'l'; spec[n++] = 'l'; spec[n++] = type; spec[n] = 0;
+                long long v = (a->type == LogArg::INT) ? a->i : (long long)a->d;
+                written = snprintf(line + used, size - used, spec, v);
+            } else if (strchr("fFeEgGaA", type)) {
+                spec[n++] = type; spec[n] = 0;
+                double v = (a->type == LogArg::DOUBLE) ? a->d : (double)a->i;
+                written = snprintf(line + used, size - used, spec, v);
+            } else if (type == 's' && a->type == LogArg::STRING) {
+                spec[n++] = 's'; spec[n] = 0;
+                written = snprintf(line + used, size - used, spec, a->s ? a->s : "(null)");
+            } else {
+                written = snprintf(line + used, size - used, "<?>");
+            }
+            if (written > 0)
+                used += written;
+            if (used > size - 1)
+                used = size - 1;
+        }
+
+        // Always end the line
+        if (used > 0 && line[used - 1] == '\n')
+            used--;
+        if (used > size - 2)
+            used = size - 2;
+        line[used++] = '\n';
+        line[used] = 0;
+    }
+};
+
+// ----------------------------
+// Level macros
+// ----------------------------
+// Compiled out entirely below EVENT_LOG_LEVEL
+
+#if EVENT_LOG_LEVEL <= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(log, ...) (log).Write(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(log, ...) ((void)0)
+#endif
+
+#if EVENT_LOG_LEVEL <= LOG_LEVEL_INFO
+#define LOG_INFO(log, ...) (log).Write(LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(log, ...) ((void)0)
+#endif
+
+#if EVENT_LOG_LEVEL <= LOG_LEVEL_WARN
+#define LOG_WARN(log, ...) (log).Write(LOG_LEVEL_WARN, __VA_ARGS__)
+#else
+#define LOG_WARN(log, ...) ((void)0)
+#endif
+
+#if EVENT_LOG_LEVEL <= LOG_LEVEL_ERROR
+#define LOG_ERROR(log, ...) (log).Write(LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define LOG_ERROR(log, ...) ((void)0)
+#endif
@@ -0,0 +1,304 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include "world.h"
+#include "scenarios.h"
+#include "world_file.h"
+
+// ----------------------------
+// Input recording and replay
+// ----------------------------
+// An interactive session is reproducible from three things: the scene it
+// started from, the seed of the generator that picks spawn radii, and every
+// structural input (click, drag) stamped with the simulation tick it was
+// applied on. Wall-clock timing does not matter - input only ever takes
+// effect between two steps.
+//
+//     InputRecorder recorder;
+//     recorder.Open("session.input", header);
+//     ...
+//     recorder.Record(world.stats().steps, command);   // before step()
+//     ...
+//     recorder.Close(world);
+//
+//     InputReplay replay;
+//     replay.Open("session.input");
+//     std::unique_ptr<World> world = replay.CreateWorld(threads);
+//     while (replay.Step(*world)) {}
+//     replay.Matches(*world);      // same positions as the recorded session?
+//
+// File: an InputLogHeader, then 12 byte InputLogEvents in tick order, then
+// (if the session ended cleanly) an INPUT_END event followed by the final
+// position checksum.
+
+#define INPUT_LOG_VERSION 6
+#define INPUT_LOG_FLUSH_TICKS 60    // a crash loses at most ~1 s of input
+
+enum InputType
+{
+    INPUT_CLICK,    // remove the clicked ball, or spawn one
+    INPUT_DRAG,     // remove the ball under the cursor, or spawn one
+    INPUT_END       // end of a recording, not a real input
+};
+
+struct InputCommand
+{
+    InputType type;
+    int x, y;
+};
+
+// What ApplyInput did
+struct InputResult
+{
+    int removed = -1;               // index of the removed ball, -1 = none
+    uint32_t removedColor = 0;
+    ParticleHandle spawned;         // the new ball, if one was spawned
+};
+
+// Applies one structural input between two steps. The ball under the cursor
+// comes from world.query() (grid lookup, not a scan over every ball); spawn
+// radii come from rng, never from rand().
+template <typename WorldType>
+InputResult ApplyInput(WorldType& world, ScenarioRng& rng, const InputCommand& input)
+{
+    InputResult result;
+    int i = world.query().Pick(input.x, input.y);
+    if (i >= 0) {
+        result.removed = i;
+        result.removedColor = world.particles().color[i];
+        world.removeBall(i);
+    } else {
+        // Clicks spawn radius 10-19, drags radius 6-15
+        double radius = (input.type == INPUT_CLICK) ? 10 + rng.Range(10) : 6 + rng.Range(10);
+        result.spawned = world.addBall(input.x, input.y, radius);
+    }
+    return result;
+}
+
+// FNV-1a over the positions, to tell whether a replay ended where the
+// recorded session did
+template <typename WorldType>
+uint64_t WorldChecksum(const WorldType& world)
+{
+    const auto& p = world.particles();
+    uint64_t h = 14695981039346656037ull;
+    const uint8_t* arrays[2] = { (const uint8_t*)p.x.data(), (const uint8_t*)p.y.data() };
+    size_t bytes = (size_t)p.size() * sizeof(p.x[0]);
+    for (int a = 0; a < 2; a++) {
+        for (size_t b = 0; b < bytes; b++) {
+            h ^= arrays[a][b];
+            h *= 1099511628211ull;
+        }
+    }
+    return h;
+}
+
+// ----------------------------
+// File layout
+// ----------------------------
+struct InputLogHeader
+{
+    char magic[8];              // "NINPUT\0\0"
+    uint32_t version;
+    uint32_t seed;              // ScenarioRng seed, spawn line and input spawns
+    uint32_t scalarBytes;       // 4 = float, 8 = double world
+    int32_t initialBalls;       // SpawnDemoLine(count, radiusRange)
+    int32_t radiusRange;
+    int32_t reserved;
+    double tickDt;              // seconds per step
+    WorldFileConfig config;
+};
+
+struct InputLogEvent
+{
+    uint32_t tick;              // steps completed when the input was applied
+    uint16_t type;              // InputType
+    int16_t x, y;
+    uint16_t reserved;
+};
+
+static const char INPUT_LOG_MAGIC[8] = { 'N', 'I', 'N', 'P', 'U', 'T', 0, 0 };
+
+// Header for a session on the demo spawn line. The actual thread count is
+// recorded (threads = 0 means "one per core" on whatever machine replays),
+// since the solver's strip layout depends on it.
+template <typename WorldType>
+InputLogHeader MakeInputLogHeader(WorldType& world, uint32_t seed, int initialBalls,
+                                  int radiusRange, double tickDt)
+{
+    InputLogHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, INPUT_LOG_MAGIC, sizeof(h.magic));
+    h.version = INPUT_LOG_VERSION;
+    h.seed = seed;
+    h.scalarBytes = sizeof(typename WorldType::Scalar);
+    h.initialBalls = initialBalls;
+    h.radiusRange = radiusRange;
+    h.tickDt = tickDt;
+    h.config = WorldFileConfig::From(world.config());
+    h.config.threads = world.threadPool().Size();
+    return h;
+}
+
+// ----------------------------
+// Recorder
+// ----------------------------
+// Writes through stdio's buffer (a few bytes per input, no syscall per
+// event); flushed every INPUT_LOG_FLUSH_TICKS ticks and on Close.
+class InputRecorder
+{
+public:
+    ~InputRecorder()
+    {
+        if (file)
+            fclose(file);
+    }
+
+    bool Open(const char* path, const InputLogHeader& header)
+    {
+        file = fopen(path, "wb");
+        if (!file)
+            return false;
+        lastFlush = 0;
+        return fwrite(&header, sizeof(header), 1, file) == 1;
+    }
+
+    bool IsOpen() const { return file != nullptr; }
+
+    void Record(long long tick, const InputCommand& input)
+    {
+        if (!file)
+            return;
+        InputLogEvent e;
+        e.tick = (uint32_t)tick;
+        e.type = (uint16_t)input.type;
+        e.x = (int16_t)input.x;
+        e.y = (int16_t)input.y;
+        e.reserved = 0;
+        fwrite(&e, sizeof(e), 1, file);
+
+        if (tick - lastFlush >= INPUT_LOG_FLUSH_TICKS) {
+            fflush(file);
+            lastFlush = tick;
+        }
+    }
+
+    // Ends the recording with the tick count and position checksum the
+    // replay has to reach
+    template <typename WorldType>
+    void Close(const WorldType& world)
+    {
+        if (!file)
+            return;
+        InputLogEvent e;
+        memset(&e, 0, sizeof(e));
+        e.tick = (uint32_t)world.stats().steps;
+        e.type = INPUT_END;
+        uint64_t checksum = WorldChecksum(world);
+        fwrite(&e, sizeof(e), 1, file);
+        fwrite(&checksum, sizeof(checksum), 1, file);
+        fclose(file);
+        file = nullptr;
+    }
+
+private:
+    FILE* file = nullptr;
+    long long lastFlush = 0;
+};
+
+// ----------------------------
+// Replay
+// ----------------------------
+class InputReplay
+{
+public:
+    // Reads the whole recording. A recording cut short (the session
+    // crashed) still replays up to its last input.
+    bool Open(const char* path)
+    {
+        events.clear();
+        complete = false;
+        FILE* f = fopen(path, "rb");
+        if (!f)
+            return false;
+
+        bool ok = fread(&header, sizeof(header), 1, f) == 1 &&
+                  memcmp(header.magic, INPUT_LOG_MAGIC, sizeof(header.magic)) == 0 &&
+                  header.version == INPUT_LOG_VERSION;
+
+        InputLogEvent e;
+        while (ok && fread(&e, sizeof(e), 1, f) == 1) {
+            if (e.type == INPUT_END) {
+                endTick = e.tick;
+                complete = fread(&endChecksum, sizeof(endChecksum), 1, f) == 1;
+                break;
+            }
+            events.push_back(e);
+        }
+        fclose(f);
+
+        if (!complete)
+            endTick = events.empty() ? 0 : events.back().tick + 1;
+        next = 0;
+        return ok;
+    }
+
+    const InputLogHeader& Header() const { return header; }
+    int EventCount() const { return (int)events.size(); }
+    long long EndTick() const { return endTick; }
+
+    // True if the recording has its end marker and checksum
+    bool Complete() const { return complete; }
+
+    // The world the session started with: recorded config and spawn line.
+    // threads <= 0 uses the recorded thread count; any other count may
+    // replay differently (see WorldConfig::threads).
+    template <typename T = Scalar>
+    std::unique_ptr<BasicWorld<T> > CreateWorld(int threads)
+    {
+        WorldConfig config = header.config.ToConfig();
+        if (threads > 0)
+            config.threads = threads;
+        std::unique_ptr<BasicWorld<T> > world(new BasicWorld<T>(config));
+        rng = ScenarioRng(header.seed);
+        SpawnDemoLine(*world, header.initialBalls, header.radiusRange, rng);
+        next = 0;
+        return world;
+    }
+
+    // Applies this tick's inputs, then steps. Returns false once the
+    // recorded session's last tick has been reached.
+    template <typename WorldType>
+    bool Step(WorldType& world)
+    {
+        long long tick = world.stats().steps;
+        if (tick >= endTick)
+            return false;
+        while (next < events.size() && events[next].tick == tick) {
+            InputCommand input = { (InputType)events[next].type, events[next].x, events[next].y };
+            ApplyInput(world, rng, input);
+            next++;
+        }
+        world.step(header.tickDt);
+        return true;
+    }
+
+    // Did the replay end on the recorded positions? (complete recordings only)
+    template <typename WorldType>
+    bool Matches(const WorldType& world) const
+    {
+        return complete && world.stats().steps == endTick && WorldChecksum(world) == endChecksum;
+    }
+
+private:
+    InputLogHeader header;
+    std::vector<InputLogEvent> events;
+    size_t next = 0;
+    long long endTick = 0;
+    uint64_t endChecksum = 0;
+    bool complete = false;
+    ScenarioRng rng{1};
+};
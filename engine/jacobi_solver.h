@@ -0,0 +1,237 @@
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+#include <vector>
+#include "particle_store.h"
+#include "spatial_grid.h"
+#include "thread_pool.h"
+#include "trace.h"
+
+// ----------------------------
+// Jacobi collision solve
+// ----------------------------
+// The default solver (ParallelSolver) is Gauss-Seidel: every contact moves
+// its two balls right away, so the next contact already sees the result
+// and the outcome depends on the pair order. The Jacobi solve runs in two
+// passes that never read what they write:
+//
+//   1. Accumulate: every ball looks at its 3x3 cell neighbourhood in the
+//      positions from before the pass and sums up the position correction
+//      and velocity change each touching neighbour would give it
+//      (ResolveBallCollision's math, taken from the ball's side).
+//   2. Apply: every ball moves by relaxation * the average of its
+//      corrections; its velocity changes by the average velocity change
+//      (relaxing that too pumps energy into piles).
+//
+// Each ball only ever writes its own accumulator and its own position, so
+// both passes split over the thread pool in any way without locks, and the
+// result is independent of the thread count. It is not independent of the
+// ball order: each ball sums its corrections in cell order, so a reorder
+// (or a removal) can change the last bits. Pass 2 is a straight loop over
+// the arrays the compiler vectorizes. The price is slower convergence: a
+// correction travels one ball per pass instead of through a whole pile, so
+// deep piles sink in further than with Gauss-Seidel at the same substep
+// count. Over-relaxing the positions (WorldConfig::relaxation, 1.5 by
+// default) wins some of that back.
+//
+// Every pair is visited from both sides, which pass 1 pays for with twice
+// the distance tests of the forward-only Gauss-Seidel scan.
+template <typename T>
+struct BasicJacobiSolver
+{
+    ThreadPool& pool;
+
+    // Below this many balls the thread hand-off costs more than it saves
+    int minParallelBalls = 4000;
+
+    // Tasks per thread and pass
+    int tasksPerThread = 4;
+
+    // Statistics of the last Solve call
+    long long pairsTested = 0;
+    int contacts = 0;
+    int wakeRequests = 0;   // sleeping balls touched by awake ones
+
+    explicit BasicJacobiSolver(ThreadPool& threads) : pool(threads) {}
+
+    // Resolves every ball-ball contact of the binned grid once.
+    // sleeping / wake: per-ball sleep flags and wake requests, or null.
+    // Returns the number of contacts.
+    int Solve(BasicParticleStore<T>& p, const SpatialGrid& grid, T elasticity, T relaxation,
+              const uint8_t* sleeping = nullptr, uint8_t* wake = nullptr)
+    {
+        int n = p.size();
+        pairsTested = 0;
+        contacts = 0;
+        wakeRequests = 0;
+
+        dx.assign(n, 0); dy.assign(n, 0);
+        dvx.assign(n, 0); dvy.assign(n, 0);
+        touching.assign(n, 0);
+
+        int tasks = 1;
+        if (n >= minParallelBalls && pool.Size() > 1)
+            tasks = pool.Size() * tasksPerThread;
+        if (tasks > grid.rows)
+            tasks = grid.rows > 0 ? grid.rows : 1;
+        taskTested.assign(tasks, 0);
+        taskContacts.assign(tasks, 0);
+        taskWakes.assign(tasks, 0);
+
+        // Pass 1, by bands of grid rows (neighbours stay in cache)
+        auto accumulate = [&](int t) {
+            int row0 = (int)((long long)grid.rows * t / tasks);
+            int row1 = (int)((long long)grid.rows * (t + 1) / tasks);
+            Accumulate(p, grid, row0, row1, t, elasticity, sleeping, wake);
+        };
+        if (tasks == 1)
+            accumulate(0);
+        else
+            pool.ParallelFor(tasks, accumulate);
+
+        // Pass 2, by ranges of balls
+        auto apply = [&](int t) {
+            int i0 = (int)((long long)n * t / tasks);
+            int i1 = (int)((long long)n * (t + 1) / tasks);
+            Apply(p, i0, i1, relaxation);
+        };
+        if (tasks == 1)
+            apply(0);
+        else
+            pool.ParallelFor(tasks, apply);
+
+        // Every pair was seen from both of its balls
+        long long touches = 0;
+        for (int t = 0; t < tasks; t++) {
+            pairsTested += taskTested[t];
+            touches += taskContacts[t];
+            wakeRequests += taskWakes[t];
+        }
+        pairsTested /= 2;
+        contacts = (int)(touches / 2);
+        return contacts;
+    }
+
+private:
+    // Per ball: summed position correction, summed velocity change and the
+    // number of touching neighbours they came from
+    AlignedArray<T> dx, dy, dvx, dvy;
+    std::vector<int> touching;
+
+    std::vector<long long> taskTested;
+    std::vector<long long> taskContacts;
+    std::vector<int> taskWakes;
+
+    void Accumulate(const BasicParticleStore<T>& p, const SpatialGrid& grid, int row0, int row1,
+                    int task, T elasticity, const uint8_t* sleeping, uint8_t* wake)
+    {
+        TRACE_SCOPE("jacobi accumulate");
+        const T* __restrict x = p.x.data();
+        const T* __restrict y = p.y.data();
+        const T* __restrict oldx = p.oldx.data();
+        const T* __restrict oldy = p.oldy.data();
+        const T* __restrict radius = p.radius.data();
+        long long tested = 0, touches = 0;
+        int wakes = 0;
+
+        for (int cy = row0; cy < row1; cy++) {
+            for (int cx = 0; cx < grid.cols; cx++) {
+                int cell = cy * grid.cols + cx;
+                for (int k = grid.cellStart[cell]; k < grid.cellStart[cell + 1]; k++) {
+                    int a = grid.cellItems[k];
+                    bool asleep = sleeping && sleeping[a];
+                    T ax = x[a], ay = y[a];
+                    T avx = ax - oldx[a], avy = ay - oldy[a];
+                    T sx = 0, sy = 0, svx = 0, svy = 0;
+                    int count = 0;
+
+                    for (int ny = cy - 1; ny <= cy + 1; ny++) {
+                        if (ny < 0 || ny >= grid.rows)
+                            continue;
+                        for (int nx = cx - 1; nx <= cx + 1; nx++) {
+                            if (nx < 0 || nx >= grid.cols)
+                                continue;
+                            int other = ny * grid.cols + nx;
+                            for (int m = grid.cellStart[other]; m < grid.cellStart[other + 1]; m++) {
+                                int b = grid.cellItems[m];
+                                if (b == a)
+                                    continue;
+                                tested++;
+                                if (asleep && sleeping[b])
+                                    continue;
+
+                                T ddx = x[b] - ax, ddy = y[b] - ay;
+                                T dist2 = ddx * ddx + ddy * ddy;
+                                T minDist = radius[a] + radius[b];
+                                if (dist2 >= minDist * minDist || dist2 == 0)
+                                    continue;
+                                touches++;
+
+                                // A sleeping ball only moves once an awake
+                                // neighbour has woken its island
+                                if (asleep) {
+                                    if (!sleeping[b] && !wake[a]) {
+                                        wake[a] = 1;
+                                        wakes++;
+                                    }
+                                    continue;
+                                }
+
+                                T dist = sqrt(dist2);
+                                T nxn = ddx / dist, nyn = ddy / dist;
+                                T correction = (minDist - dist) * T(0.5);
+                                sx -= nxn * correction;
+                                sy -= nyn * correction;
+
+                                // Restitution on the velocities after both
+                                // balls took their half of the correction
+                                T velAlongNormal = ((x[b] - oldx[b]) - avx) * nxn +
+                                                   ((y[b] - oldy[b]) - avy) * nyn + 2 * correction;
+                                if (velAlongNormal < 0) {
+                                    T impulse = -(1 + elasticity) * velAlongNormal * T(0.5);
+                                    svx -= impulse * nxn;
+                                    svy -= impulse * nyn;
+                                }
+                                count++;
+                            }
+                        }
+                    }
+
+                    dx[a] = sx; dy[a] = sy;
+                    dvx[a] = svx; dvy[a] = svy;
+                    touching[a] = count;
+                }
+            }
+        }
+
+        taskTested[task] = tested;
+        taskContacts[task] = touches;
+        taskWakes[task] = wakes;
+    }
+
+    // x += w * mean correction; the velocity change goes into oldx so the
+    // correction itself also counts as velocity, as in the Gauss-Seidel path
+    void Apply(BasicParticleStore<T>& p, int i0, int i1, T relaxation)
+    {
+        TRACE_SCOPE("jacobi apply");
+        T* __restrict x = p.x.data();
+        T* __restrict y = p.y.data();
+        T* __restrict oldx = p.oldx.data();
+        T* __restrict oldy = p.oldy.data();
+        const T* __restrict sx = dx.data();
+        const T* __restrict sy = dy.data();
+        const T* __restrict svx = dvx.data();
+        const T* __restrict svy = dvy.data();
+        const int* __restrict count = touching.data();
+
+        for (int i = i0; i < i1; i++) {
+            T mean = T(1) / (T)(count[i] > 0 ? count[i] : 1);
+            T w = relaxation * mean;
+            x[i] += w * sx[i];
+            y[i] += w * sy[i];
+            oldx[i] -= mean * svx[i];
+            oldy[i] -= mean * svy[i];
+        }
+    }
+};
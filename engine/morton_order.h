@@ -0,0 +1,162 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include "particle_store.h"
+#include "thread_pool.h"
+
+// ----------------------------
+// Morton order
+// ----------------------------
+// Balls are stored in the order they were added, and swap-and-pop removal
+// shuffles them further. After a while neighbours in space are far apart
+// in the arrays and every grid cell the solver visits is a handful of
+// cache misses. Sorting the balls along a Z-order curve puts balls that
+// are close in space close in memory again:
+//
+//     key = interleaved bits of (x, y) quantized to 16 bits each
+//
+//     0 1 4 5
+//     2 3 6 7      cells visited in key order: small squares first,
+//     8 9 . .      then the squares made of them, and so on
+//
+// The sort is an LSD radix sort, 8 bits per pass, over (key, index) pairs.
+// Every pass splits the balls into chunks: each task counts the digits of
+// its chunk, one serial prefix sum over (digit, task) gives every task its
+// own output ranges, and each task scatters its chunk - no locks. The sort
+// is stable, so the order only depends on the positions, not on the number
+// of tasks. Passes where every key has the same digit are skipped.
+//
+// The store is then permuted with BasicParticleStore::Permute, which keeps
+// ParticleHandles valid; indices held across the reorder are not.
+
+// Spreads the low 16 bits of v to the even bit positions
+inline uint32_t MortonSpread(uint32_t v)
+{
+    v &= 0xffff;
+    v = (v | (v << 8)) & 0x00ff00ff;
+    v = (v | (v << 4)) & 0x0f0f0f0f;
+    v = (v | (v << 2)) & 0x33333333;
+    v = (v | (v << 1)) & 0x55555555;
+    return v;
+}
+
+inline uint32_t MortonKey(uint32_t qx, uint32_t qy)
+{
+    return MortonSpread(qx) | (MortonSpread(qy) << 1);
+}
+
+struct MortonOrder
+{
+    // Below this many balls the thread hand-off costs more than it saves
+    int minParallelBalls = 16384;
+
+    // Tasks per thread and pass
+    int tasksPerThread = 2;
+
+    // order[k] = old index of the ball that goes to index k
+    std::vector<int> order;
+
+    // Computes order for the current positions (does not move anything)
+    template <typename T>
+    const std::vector<int>& Sort(const BasicParticleStore<T>& p, ThreadPool& pool)
+    {
+        int n = p.size();
+        keys.resize(n);
+        order.resize(n);
+        keysOut.resize(n);
+        orderOut.resize(n);
+        if (n == 0)
+            return order;
+
+        // One scale for both axes, so the curve's squares stay square
+        double minX = p.x[0], maxX = p.x[0];
+        double minY = p.y[0], maxY = p.y[0];
+        for (int i = 1; i < n; i++) {
+            if (p.x[i] < minX) minX = p.x[i];
+            if (p.x[i] > maxX) maxX = p.x[i];
+            if (p.y[i] < minY) minY = p.y[i];
+            if (p.y[i] > maxY) maxY = p.y[i];
+        }
+        double extent = maxX - minX > maxY - minY ? maxX - minX : maxY - minY;
+        double scale = extent > 0.0 ? 65535.0 / extent : 0.0;
+
+        int tasks = 1;
+        if (n >= minParallelBalls && pool.Size() > 1)
+            tasks = pool.Size() * tasksPerThread;
+
+        ForChunks(pool, tasks, n, [&](int, int i0, int i1) {
+            for (int i = i0; i < i1; i++) {
+                uint32_t qx = (uint32_t)((p.x[i] - minX) * scale);
+                uint32_t qy = (uint32_t)((p.y[i] - minY) * scale);
+                keys[i] = MortonKey(qx, qy);
+                order[i] = i;
+            }
+        });
+
+        counts.resize((size_t)tasks * 256);
+        for (int shift = 0; shift < 32; shift += 8) {
+            // 1. Digit counts per task
+            ForChunks(pool, tasks, n, [&](int t, int i0, int i1) {
+                int* count = &counts[(size_t)t * 256];
+                for (int d = 0; d < 256; d++)
+                    count[d] = 0;
+                for (int i = i0; i < i1; i++)
+                    count[(keys[i] >> shift) & 0xff]++;
+            });
+
+            // Every key has the same digit: nothing moves
+            bool trivial = false;
+            for (int d = 0; d < 256 && !trivial; d++) {
+                int total = 0;
+                for (int t = 0; t < tasks; t++)
+                    total += counts[(size_t)t * 256 + d];
+                trivial = (total == n);
+            }
+            if (trivial)
+                continue;
+
+            // 2. Output start of every (digit, task), digit-major so the
+            //    sort stays stable
+            int offset = 0;
+            for (int d = 0; d < 256; d++) {
+                for (int t = 0; t < tasks; t++) {
+                    int c = counts[(size_t)t * 256 + d];
+                    counts[(size_t)t * 256 + d] = offset;
+                    offset += c;
+                }
+            }
+
+            // 3. Scatter
+            ForChunks(pool, tasks, n, [&](int t, int i0, int i1) {
+                int* cursor = &counts[(size_t)t * 256];
+                for (int i = i0; i < i1; i++) {
+                    int k = cursor[(keys[i] >> shift) & 0xff]++;
+                    keysOut[k] = keys[i];
+                    orderOut[k] = order[i];
+                }
+            });
+            keys.swap(keysOut);
+            order.swap(orderOut);
+        }
+        return order;
+    }
+
+private:
+    std::vector<uint32_t> keys, keysOut;
+    std::vector<int> orderOut;
+    std::vector<int> counts;    // 256 per task
+
+    // task(t, i0, i1) over tasks equal chunks of [0, n)
+    template <typename Task>
+    static void ForChunks(ThreadPool& pool, int tasks, int n, Task task)
+    {
+        auto chunk = [&](int t) {
+            task(t, (int)((long long)n * t / tasks), (int)((long long)n * (t + 1) / tasks));
+        };
+        if (tasks == 1)
+            chunk(0);
+        else
+            pool.ParallelFor(tasks, chunk);
+    }
+};
@@ -0,0 +1,266 @@
+#pragma once
+
+#include <vector>
+#include <math.h>
+#include "particle_store.h"
+#include "spatial_grid.h"
+
+// ----------------------------
+// Multi-level grid broadphase
+// ----------------------------
+// SpatialGrid sizes its cells for the largest ball, so with radii 6-20 a
+// small ball still scans nine 40 px cells full of other balls. This grid
+// keeps a stack of levels instead, each with cells twice the size of the
+// one below:
+//
+//     top       cell = largest diameter         balls above half of it
+//     top - 1   cell = half of that             balls above a quarter
+//     ...
+//     level 0   finest cell still >= the smallest diameter
+//
+// Every ball goes to the finest level whose cells are at least its
+// diameter. Pairs within a level come from the usual 3x3 neighbourhood
+// (forward half, as in SpatialGrid); pairs across levels are found from
+// the smaller ball, which looks at the cells around it on every coarser
+// level, as far as that level's largest ball can reach. Each pair shows up exactly once, and a ball only ever
+// meets candidates of its own size or bigger.
+//
+// All levels share one origin and are rebuilt from the ball bounds every
+// time, so the grid follows an open world wherever it spreads. Cells are
+// one counting sort over all levels together; no per-cell vectors.
+//
+// Drop-in for SpatialGrid in ParallelSolver: cols / rows are the top
+// level's, and ForEachPairInColumns takes top level columns. A touching
+// pair is never more than one top level cell apart, so the checkerboard
+// strip argument in parallel_solver.h holds unchanged.
+
+#define MULTILEVEL_MAX_LEVELS 16
+
+struct MultiLevelGrid
+{
+    struct Level
+    {
+        double cellSize;
+        int cols, rows;
+        int firstCell;          // index of its cell (0, 0) in cellStart
+        int balls;              // balls binned on this level
+        double maxRadius;       // largest of them
+    };
+
+    double originX = 0.0, originY = 0.0;
+    std::vector<Level> levels;
+
+    // Top level, for strip layouts
+    double cellSize = 1.0;
+    int cols = 0, rows = 0;
+
+    std::vector<int> cellStart;   // all levels' cells + 1 offsets into cellItems
+    std::vector<int> cellItems;   // ball indices, grouped by cell
+    std::vector<int> ballCell;    // cell index (into cellStart) of every ball
+
+    // Statistics of the last ForEachPair call
+    long long pairsTested = 0;
+
+    int LevelCount() const { return (int)levels.size(); }
+
+    // Cell of a point on level l, clamped to the grid
+    int CellIndex(int l, double x, double y) const
+    {
+        const Level& level = levels[l];
+        int cx = GridCellClamp((x - originX) / level.cellSize, level.cols);
+        int cy = GridCellClamp((y - originY) / level.cellSize, level.rows);
+        return level.firstCell + cy * level.cols + cx;
+    }
+
+    template <typename T>
+    void Build(const BasicParticleStore<T>& p)
+    {
+        Build(p.x.data(), p.y.data(), p.radius.data(), p.size());
+    }
+
+    template <typename T>
+    void Build(const T* x, const T* y, const T* radius, int n)
+    {
+        ballCell.resize(n);
+        cellItems.resize(n);
+        levels.clear();
+
+        if (n == 0) {
+            cols = rows = 0;
+            cellStart.assign(1, 0);
+            return;
+        }
+
+        // Finite bounds only, as in SpatialGrid
+        GridBounds bounds(x, y, radius, n);
+        double width = bounds.width;
+        double height = bounds.height;
+        double minRadius = bounds.minRadius;
+
+        // Top level: the largest diameter, grown (as in SpatialGrid) until
+        // there are not many more cells than balls, whatever the spread
+        double maxCells = 4.0 * n + 64.0;
+        double topSize = GridCellSize(bounds, 2.0 * bounds.maxRadius, maxCells);
+
+        // Halve down to the level that still holds the smallest ball, within
+        // the same cell limit
+        double size0 = topSize;
+        int levelCount = 1;
+        while (levelCount < MULTILEVEL_MAX_LEVELS && size0 * 0.5 >= 2.0 * minRadius &&
+               (width / (size0 * 0.5) + 1.0) * (height / (size0 * 0.5) + 1.0) <= maxCells) {
+            size0 *= 0.5;
+            levelCount++;
+        }
+
+        originX = bounds.minX;
+        originY = bounds.minY;
+        int cellCount = 0;
+        double size = size0;
+        for (int l = 0; l < levelCount; l++, size *= 2.0) {
+            Level level;
+            level.cellSize = size;
+            level.cols = (int)(width / size) + 1;
+            level.rows = (int)(height / size) + 1;
+            level.firstCell = cellCount;
+            level.balls = 0;
+            level.maxRadius = 0.0;
+            levels.push_back(level);
+            cellCount += level.cols * level.rows;
+        }
+
+        const Level& top = levels.back();
+        cellSize = top.cellSize;
+        cols = top.cols;
+        rows = top.rows;
+
+        cellStart.assign(cellCount + 1, 0);
+
+        // 1. Level and cell of every ball, counted
+        for (int i = 0; i < n; i++) {
+            int l = 0;
+            double diameter = 2.0 * radius[i];
+            while (l + 1 < LevelCount() && levels[l].cellSize < diameter)
+                l++;
+            levels[l].balls++;
+            if (radius[i] > levels[l].maxRadius && isfinite((double)radius[i]))
+                levels[l].maxRadius = radius[i];
+            ballCell[i] = CellIndex(l, x[i], y[i]);
+            cellStart[ballCell[i] + 1]++;
+        }
+
+        // 2. Prefix sum
+        for (int c = 0; c < cellCount; c++)
+            cellStart[c + 1] += cellStart[c];
+
+        // 3. Scatter (keeps ball order inside each cell)
+        std::vector<int>& cursor = scratch;
+        cursor.assign(cellStart.begin(), cellStart.end() - 1);
+        for (int i = 0; i < n; i++)
+            cellItems[cursor[ballCell[i]]++] = i;
+    }
+
+    template <typename Visit>
+    void ForEachPair(Visit visit)
+    {
+        pairsTested = ForEachPairInColumns(0, cols, visit);
+    }
+
+    // Pairs whose smaller ball (or first ball, on the same level) sits in
+    // top level columns [col0, col1). The other ball is at most one top
+    // level column outside the range. Returns the number of pairs visited.
+    template <typename Visit>
+    long long ForEachPairInColumns(int col0, int col1, Visit visit) const
+    {
+        long long tested = 0;
+        int topLevel = LevelCount() - 1;
+
+        static const int offsets[4][2] = { {1, 0}, {-1, 1}, {0, 1}, {1, 1} };
+
+        for (int l = 0; l <= topLevel; l++) {
+            const Level& level = levels[l];
+            if (level.balls == 0)
+                continue;
+
+            int shift = topLevel - l;
+            int cx0 = col0 << shift;
+            int cx1 = col1 << shift;
+            if (cx1 > level.cols)
+                cx1 = level.cols;
+
+            for (int cy = 0; cy < level.rows; cy++) {
+                for (int cx = cx0; cx < cx1; cx++) {
+                    int cell = level.firstCell + cy * level.cols + cx;
+                    int begin = cellStart[cell];
+                    int end = cellStart[cell + 1];
+                    if (begin == end)
+                        continue;
+
+                    // Same level: inside the cell, then the forward neighbours
+                    for (int a = begin; a < end; a++) {
+                        for (int b = a + 1; b < end; b++) {
+                            visit(cellItems[a], cellItems[b]);
+                            tested++;
+                        }
+                    }
+                    for (int k = 0; k < 4; k++) {
+                        int nx = cx + offsets[k][0];
+                        int ny = cy + offsets[k][1];
+                        if (nx < 0 || nx >= level.cols || ny >= level.rows)
+                            continue;
+                        tested += VisitCells(begin, end, level.firstCell + ny * level.cols + nx, visit);
+                    }
+
+                    // Every coarser level: the cells any ball of this cell
+                    // can reach (at most 3x3, usually 2x2)
+                    for (int L = l + 1; L <= topLevel; L++) {
+                        const Level& coarse = levels[L];
+                        if (coarse.balls == 0)
+                            continue;
+                        double reach = level.maxRadius + coarse.maxRadius;
+                        int nx0, nx1, ny0, ny1;
+                        CoarseRange(cx, level.cellSize, reach, coarse.cellSize, coarse.cols, nx0, nx1);
+                        CoarseRange(cy, level.cellSize, reach, coarse.cellSize, coarse.rows, ny0, ny1);
+                        for (int ny = ny0; ny <= ny1; ny++)
+                            for (int nx = nx0; nx <= nx1; nx++)
+                                tested += VisitCells(begin, end, coarse.firstCell + ny * coarse.cols + nx, visit);
+                    }
+                }
+            }
+        }
+        return tested;
+    }
+
+    // Writes every candidate pair into pairs (a0, b0, a1, b1, ...), in the
+    // same order ForEachPair visits them
+    void CollectPairs(std::vector<int>& pairs)
+    {
+        pairs.clear();
+        ForEachPair([&](int a, int b) {
+            pairs.push_back(a);
+            pairs.push_back(b);
+        });
+    }
+
+private:
+    std::vector<int> scratch;
+
+    // Coarse cells [c0, c1] overlapping fine cell c grown by reach, on one axis
+    static void CoarseRange(int c, double size, double reach, double coarseSize, int count,
+                            int& c0, int& c1)
+    {
+        c0 = GridCellClamp(floor((c * size - reach) / coarseSize), count);
+        c1 = GridCellClamp(floor(((c + 1) * size + reach) / coarseSize), count);
+    }
+
+    // Every ball of cellItems[begin, end) against every ball of cell other
+    template <typename Visit>
+    long long VisitCells(int begin, int end, int other, Visit& visit) const
+    {
+        int otherBegin = cellStart[other];
+        int otherEnd = cellStart[other + 1];
+        for (int a = begin; a < end; a++)
+            for (int b = otherBegin; b < otherEnd; b++)
+                visit(cellItems[a], cellItems[b]);
+        return (long long)(end - begin) * (otherEnd - otherBegin);
+    }
+};
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <vector>
+#include "particle_store.h"
+#include "spatial_grid.h"
+#include "simd_collide.h"
+#include "thread_pool.h"
+#include "policies.h"
+#include "trace.h"
+
+// ----------------------------
+// Parallel collision solve (checkerboard strips)
+// ----------------------------
+// The grid columns are cut into vertical strips at least 2 cells wide and
+// solved in two phases:
+//
+//     | 0 | 1 | 0 | 1 | 0 | 1 |     phase 0: all even strips at once
+//                                   phase 1: all odd strips at once
+//
+// A strip only writes balls binned in its own columns plus one column on
+// either side. With strips >= 2 columns wide, two strips of the same phase
+// are always separated by a full strip, so no ball is ever written by two
+// threads at the same time. No locks, no atomics on the particle data.
+//
+// Each strip collects its candidate pairs and hands them to the SIMD narrow
+// phase, so threading and SIMD stack.
+//
+// With sleeping enabled, pairs of two sleeping balls are dropped before the
+// narrow phase, and a touching awake ball flags its sleeping partner in
+// wake[]. That write follows the same strip ownership as the positions.
+//
+// Grid is SpatialGrid or MultiLevelGrid: anything with cols and a
+// ForEachPairInColumns whose pairs reach at most one column outside.
+struct ParallelSolver
+{
+    ThreadPool& pool;
+
+    // Below this many balls the thread hand-off costs more than it saves
+    int minParallelBalls = 4000;
+
+    // Strips per thread and phase; more than one evens out dense vs empty strips
+    int stripsPerThread = 4;
+
+    // Statistics of the last Solve call
+    long long pairsTested = 0;
+    int contacts = 0;
+    int wakeRequests = 0;   // sleeping balls touched by awake ones
+
+    explicit ParallelSolver(ThreadPool& threads) : pool(threads) {}
+
+    // Resolves every ball-ball contact of the binned grid.
+    // sleeping / wake: per-ball sleep flags and wake requests, or null.
+    // Response is the collision response policy (policies.h).
+    // Returns the number of contacts.
+    template <typename Response = ElasticResponse, typename T, typename Grid>
+    int Solve(BasicParticleStore<T>& p, const Grid& grid, T elasticity,
+              const uint8_t* sleeping = nullptr, uint8_t* wake = nullptr)
+    {
+        pairsTested = 0;
+        contacts = 0;
+        wakeRequests = 0;
+
+        // Strip layout: 2 phases * threads * stripsPerThread strips, each at
+        // least 2 columns wide
+        int wanted = 2 * pool.Size() * stripsPerThread;
+        int stripCount = grid.cols / 2;
+        if (stripCount > wanted)
+            stripCount = wanted;
+
+        if (p.size() < minParallelBalls || pool.Size() == 1 || stripCount < 2) {
+            Resize(1);
+            SolveColumns<Response>(p, grid, 0, grid.cols, 0, elasticity, sleeping, wake);
+            Reduce(1);
+            return contacts;
+        }
+
+        Resize(stripCount);
+
+        for (int phase = 0; phase < 2; phase++) {
+            int phaseStrips = (stripCount - phase + 1) / 2;
+            pool.ParallelFor(phaseStrips, [&](int k) {
+                int strip = 2 * k + phase;
+                int col0 = (int)((long long)grid.cols * strip / stripCount);
+                int col1 = (int)((long long)grid.cols * (strip + 1) / stripCount);
+                SolveColumns<Response>(p, grid, col0, col1, strip, elasticity, sleeping, wake);
+            });
+        }
+
+        Reduce(stripCount);
+        return contacts;
+    }
+
+private:
+    std::vector<std::vector<int> > stripPairs;
+    std::vector<std::vector<int> > stripSurvivors;
+    std::vector<long long> stripTested;
+    std::vector<int> stripContacts;
+    std::vector<int> stripWakes;
+
+    void Resize(int strips)
+    {
+        if ((int)stripPairs.size() < strips) {
+            stripPairs.resize(strips);
+            stripSurvivors.resize(strips);
+            stripTested.resize(strips);
+            stripContacts.resize(strips);
+            stripWakes.resize(strips);
+        }
+    }
+
+    template <typename Response, typename T, typename Grid>
+    void SolveColumns(BasicParticleStore<T>& p, const Grid& grid, int col0, int col1,
+                      int strip, T elasticity, const uint8_t* sleeping, uint8_t* wake)
+    {
+        TRACE_SCOPE("strip");
+        std::vector<int>& pairs = stripPairs[strip];
+        int wakes = 0;
+
+        pairs.clear();
+        stripTested[strip] = grid.ForEachPairInColumns(col0, col1, [&](int a, int b) {
+            if (sleeping && (sleeping[a] | sleeping[b])) {
+                // Two sleeping balls: nothing to do
+                if (sleeping[a] & sleeping[b])
+                    return;
+
+                // Awake ball touching a sleeping one: wake it (and its island)
+                T dx = p.x[b] - p.x[a];
+                T dy = p.y[b] - p.y[a];
+                T minDist = p.radius[a] + p.radius[b];
+                if (dx * dx + dy * dy < minDist * minDist) {
+                    int sleeper = sleeping[a] ? a : b;
+                    if (!wake[sleeper]) {
+                        wake[sleeper] = 1;
+                        wakes++;
+                    }
+                }
+            }
+            pairs.push_back(a);
+            pairs.push_back(b);
+        });
+        stripWakes[strip] = wakes;
+        stripContacts[strip] = Response::ResolveBatch(p, pairs.data(), (int)pairs.size() / 2,
+                                                      elasticity, stripSurvivors[strip]);
+    }
+
+    void Reduce(int strips)
+    {
+        for (int s = 0; s < strips; s++) {
+            pairsTested += stripTested[s];
+            contacts += stripContacts[s];
+            wakeRequests += stripWakes[s];
+        }
+    }
+};
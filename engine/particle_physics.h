@@ -0,0 +1,229 @@
+#pragma once
+
+#include <math.h>
+#include "particle_store.h"
+
+// Batch versions of the per-Circle physics in the demos. Same math, but they
+// walk the ParticleStore arrays directly so the loops stay tight and
+// vectorizable. Constants are passed in because every demo #defines its own.
+// Everything is templated on the scalar type of the store (see scalar.h).
+
+// ----------------------------
+// Verlet integration step (all particles)
+// ----------------------------
+// velocityScale is dt / previous dt; 1.0 for a fixed timestep.
+template <typename T>
+inline void UpdateCircles(BasicParticleStore<T>& p, typename BasicParticleStore<T>::Scalar gravity,
+                          typename BasicParticleStore<T>::Scalar velocityScale = 1, const uint8_t* sleeping = nullptr)
+{
+    T* __restrict x = p.x.data();
+    T* __restrict y = p.y.data();
+    T* __restrict oldx = p.oldx.data();
+    T* __restrict oldy = p.oldy.data();
+    int n = p.size();
+
+    if (sleeping == nullptr) {
+        for (int i = 0; i < n; i++) {
+            T vx = (x[i] - oldx[i]) * velocityScale;
+            T vy = (y[i] - oldy[i]) * velocityScale;
+
+            // Store current position
+            oldx[i] = x[i];
+            oldy[i] = y[i];
+
+            // Integrate position (gravity acts downward)
+            x[i] += vx;
+            y[i] += vy + gravity;
+        }
+        return;
+    }
+
+    // Sleeping balls stay where they are (kept as a separate loop so the
+    // common case above stays branch-free)
+    for (int i = 0; i < n; i++) {
+        if (sleeping[i])
+            continue;
+
+        T vx = (x[i] - oldx[i]) * velocityScale;
+        T vy = (y[i] - oldy[i]) * velocityScale;
+
+        oldx[i] = x[i];
+        oldy[i] = y[i];
+
+        x[i] += vx;
+        y[i] += vy + gravity;
+    }
+}
+
+// ----------------------------
+// Circular container constraint (one particle)
+// ----------------------------
+template <typename T>
+inline void ApplyCircularConstraint(BasicParticleStore<T>& p, int i,
+                                    typename BasicParticleStore<T>::Scalar cx, typename BasicParticleStore<T>::Scalar cy, typename BasicParticleStore<T>::Scalar cr,
+                                    typename BasicParticleStore<T>::Scalar elasticity)
+{
+    // Vector from container center to particle
+    T dx = p.x[i] - cx;
+    T dy = p.y[i] - cy;
+
+    T dist2 = dx*dx + dy*dy;
+    T maxDist = cr - p.radius[i];
+
+    // Inside: nothing to do (and no sqrt needed to find out)
+    if (maxDist >= 0 && dist2 <= maxDist * maxDist)
+        return;
+
+    T dist = sqrt(dist2);
+    if (dist == 0)
+        return;
+
+    // Capture velocity before modifying position
+    T vx = p.x[i] - p.oldx[i];
+    T vy = p.y[i] - p.oldy[i];
+
+    // Normal vector
+    T nx = dx / dist;
+    T ny = dy / dist;
+
+    // Snap particle back onto boundary
+    p.x[i] = cx + nx * maxDist;
+    p.y[i] = cy + ny * maxDist;
+
+    // Reflect velocity across normal and apply elasticity
+    T dot = vx * nx + vy * ny;
+    vx = (vx - 2 * dot * nx) * elasticity;
+    vy = (vy - 2 * dot * ny) * elasticity;
+
+    // Reconstruct previous position
+    p.oldx[i] = p.x[i] - vx;
+    p.oldy[i] = p.y[i] - vy;
+}
+
+// ----------------------------
+// Circular container constraint (all particles)
+// ----------------------------
+template <typename T>
+inline void ApplyCircularConstraints(BasicParticleStore<T>& p,
+                                     typename BasicParticleStore<T>::Scalar cx, typename BasicParticleStore<T>::Scalar cy, typename BasicParticleStore<T>::Scalar cr,
+                                     typename BasicParticleStore<T>::Scalar elasticity)
+{
+    int n = p.size();
+    for (int i = 0; i < n; i++)
+        ApplyCircularConstraint(p, i, cx, cy, cr, elasticity);
+}
+
+// ----------------------------
+// Box wall constraint (all particles)
+// ----------------------------
+// Walls at x = 0, x = width, y = 0, y = height. A ball past a wall is put
+// back against it and its velocity on that axis is flipped and scaled.
+template <typename T>
+inline void ApplyBoxConstraints(BasicParticleStore<T>& p, typename BasicParticleStore<T>::Scalar width, typename BasicParticleStore<T>::Scalar height,
+                                typename BasicParticleStore<T>::Scalar elasticity)
+{
+    int n = p.size();
+    for (int i = 0; i < n; i++) {
+        T r = p.radius[i];
+        T vx = p.x[i] - p.oldx[i];
+        T vy = p.y[i] - p.oldy[i];
+
+        // Left / right wall
+        if (p.x[i] < r) {
+            p.x[i] = r;
+            p.oldx[i] = p.x[i] + vx * elasticity;
+        }
+        if (p.x[i] > width - r) {
+            p.x[i] = width - r;
+            p.oldx[i] = p.x[i] + vx * elasticity;
+        }
+
+        // Top / bottom wall
+        if (p.y[i] < r) {
+            p.y[i] = r;
+            p.oldy[i] = p.y[i] + vy * elasticity;
+        }
+        if (p.y[i] > height - r) {
+            p.y[i] = height - r;
+            p.oldy[i] = p.y[i] + vy * elasticity;
+        }
+    }
+}
+
+// ----------------------------
+// Ball-ball collision (one pair, by index)
+// ----------------------------
+// Returns true if the pair was overlapping.
+template <typename T>
+inline bool ResolveBallCollision(BasicParticleStore<T>& p, int a, int b, typename BasicParticleStore<T>::Scalar elasticity)
+{
+    // Vector between centers
+    T dx = p.x[b] - p.x[a];
+    T dy = p.y[b] - p.y[a];
+
+    T dist2 = dx*dx + dy*dy;
+    T minDist = p.radius[a] + p.radius[b];
+
+    // No collision - rejected before paying for the sqrt
+    if (dist2 >= minDist * minDist || dist2 == 0)
+        return false;
+
+    T dist = sqrt(dist2);
+
+    // Normalized collision normal
+    T invDist = 1 / dist;
+    T nx = dx * invDist;
+    T ny = dy * invDist;
+
+    // -------- POSITION CORRECTION --------
+    T correction = (minDist - dist) * T(0.5);
+
+    p.x[a] -= nx * correction;
+    p.y[a] -= ny * correction;
+    p.x[b] += nx * correction;
+    p.y[b] += ny * correction;
+
+    // -------- VELOCITY (VERLET STYLE) --------
+    T avx = p.x[a] - p.oldx[a];
+    T avy = p.y[a] - p.oldy[a];
+    T bvx = p.x[b] - p.oldx[b];
+    T bvy = p.y[b] - p.oldy[b];
+
+    // Velocity along normal
+    T velAlongNormal = (bvx - avx) * nx + (bvy - avy) * ny;
+
+    // If balls are separating, don't resolve
+    if (velAlongNormal > 0)
+        return true;
+
+    // Elastic response, equal mass
+    T impulse = -(1 + elasticity) * velAlongNormal * T(0.5);
+
+    T ix = impulse * nx;
+    T iy = impulse * ny;
+
+    // Reconstruct old positions
+    p.oldx[a] = p.x[a] - (avx - ix);
+    p.oldy[a] = p.y[a] - (avy - iy);
+    p.oldx[b] = p.x[b] - (bvx + ix);
+    p.oldy[b] = p.y[b] - (bvy + iy);
+
+    return true;
+}
+
+// ----------------------------
+// Ball-ball collision (list of candidate pairs)
+// ----------------------------
+// pairs holds index pairs back to back: a0, b0, a1, b1, ...
+// Returns the number of pairs that were actually touching.
+template <typename T>
+inline int ResolveBallCollisions(BasicParticleStore<T>& p, const int* pairs, int pairCount,
+                                 typename BasicParticleStore<T>::Scalar elasticity)
+{
+    int contacts = 0;
+    for (int k = 0; k < pairCount; k++) {
+        if (ResolveBallCollision(p, pairs[2*k], pairs[2*k + 1], elasticity))
+            contacts++;
+    }
+    return contacts;
+}
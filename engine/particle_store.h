@@ -0,0 +1,346 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <new>
+#include <vector>
+#include "scalar.h"
+
+// ----------------------------
+// Aligned allocator
+// ----------------------------
+// Hot arrays start on a 64 byte boundary (one cache line, and wide enough
+// for any SIMD load we use).
+template <typename T, size_t Alignment = 64>
+struct AlignedAllocator
+{
+    typedef T value_type;
+
+    template <typename U>
+    struct rebind { typedef AlignedAllocator<U, Alignment> other; };
+
+    AlignedAllocator() {}
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+    T* allocate(size_t n)
+    {
+        return (T*)::operator new(n * sizeof(T), std::align_val_t(Alignment));
+    }
+
+    void deallocate(T* p, size_t)
+    {
+        ::operator delete(p, std::align_val_t(Alignment));
+    }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U, Alignment>&) const { return true; }
+    template <typename U>
+    bool operator!=(const AlignedAllocator<U, Alignment>&) const { return false; }
+};
+
+template <typename T>
+using AlignedArray = std::vector<T, AlignedAllocator<T> >;
+
+typedef AlignedArray<double> AlignedDoubles;
+
+// ----------------------------
+// Particle handle
+// ----------------------------
+// References into the arrays of one particle, so demo code can keep
+// writing balls[i].x, balls[i].radius, balls[i].color, ...
+template <typename T>
+struct BasicParticleRef
+{
+    T& x;
+    T& y;
+    T& oldx;
+    T& oldy;
+    T& radius;
+    uint32_t& color;
+};
+
+// ----------------------------
+// Stable particle handle
+// ----------------------------
+// Indices change when a ball is removed (the last ball moves into the hole),
+// handles do not. A handle names a slot plus the slot's generation; removing
+// the ball bumps the generation, so old handles to a reused slot go stale
+// instead of silently pointing at the next ball.
+struct ParticleHandle
+{
+    uint32_t slot = 0xffffffffu;
+    uint32_t generation = 0;
+
+    bool operator==(const ParticleHandle& o) const { return slot == o.slot && generation == o.generation; }
+    bool operator!=(const ParticleHandle& o) const { return !(*this == o); }
+};
+
+// ----------------------------
+// Structure-of-arrays particle storage
+// ----------------------------
+// Hot data (everything the physics touches every substep) lives in its own
+// contiguous, aligned array. Cold data (render-only color) sits in a side
+// table so the solver never drags it through the cache.
+//
+// The arrays stay dense: Remove() moves the last ball into the hole
+// (swap-and-pop), so adding and removing are O(1) and nothing ever shifts.
+// A slot table with a free list maps ParticleHandles to the current index.
+// reserve() up front and no array reallocates while balls come and go.
+//
+// T is the scalar type of positions and radii (see scalar.h).
+template <typename T>
+struct BasicParticleStore
+{
+    typedef T Scalar;
+
+    // Hot
+    AlignedArray<T> x, y;
+    AlignedArray<T> oldx, oldy;
+    AlignedArray<T> radius;
+
+    // Sleep state (only used when the world has sleeping enabled)
+    std::vector<uint8_t> sleeping;    // 1 = skipped by integration and by sleeping-sleeping pairs
+    std::vector<uint8_t> wake;        // set by the solver when a ball touches a sleeping one
+
+    // Cold
+    std::vector<uint32_t> color;
+
+    // Sleep bookkeeping
+    AlignedArray<T> anchorX, anchorY; // where the ball started resting
+    std::vector<int> restSteps;       // steps spent near the anchor
+    std::vector<int> island;          // island (contact group) id from the last sleep update
+
+    // Handles: ballSlot[i] is the slot of ball i, slotIndex[s] the ball in
+    // slot s, freeSlots the slots of removed balls, reused first
+    std::vector<uint32_t> ballSlot;
+    std::vector<uint32_t> slotIndex;
+    std::vector<uint32_t> slotGeneration;
+    std::vector<uint32_t> freeSlots;
+
+    int size() const { return (int)x.size(); }
+    bool empty() const { return x.empty(); }
+
+    void reserve(size_t n)
+    {
+        x.reserve(n); y.reserve(n);
+        oldx.reserve(n); oldy.reserve(n);
+        radius.reserve(n);
+        sleeping.reserve(n); wake.reserve(n);
+        color.reserve(n);
+        anchorX.reserve(n); anchorY.reserve(n);
+        restSteps.reserve(n); island.reserve(n);
+        ballSlot.reserve(n);
+        slotIndex.reserve(n); slotGeneration.reserve(n); freeSlots.reserve(n);
+    }
+
+    void clear()
+    {
+        x.clear(); y.clear();
+        oldx.clear(); oldy.clear();
+        radius.clear();
+        sleeping.clear(); wake.clear();
+        color.clear();
+        anchorX.clear(); anchorY.clear();
+        restSteps.clear(); island.clear();
+
+        // Every live handle goes stale
+        for (size_t i = 0; i < ballSlot.size(); i++) {
+            slotGeneration[ballSlot[i]]++;
+            freeSlots.push_back(ballSlot[i]);
+        }
+        ballSlot.clear();
+    }
+
+    int Add(double px, double py, double pOldx, double pOldy, double r, uint32_t c)
+    {
+        x.push_back((T)px); y.push_back((T)py);
+        oldx.push_back((T)pOldx); oldy.push_back((T)pOldy);
+        radius.push_back((T)r);
+        sleeping.push_back(0); wake.push_back(0);
+        color.push_back(c);
+        anchorX.push_back((T)px); anchorY.push_back((T)py);
+        restSteps.push_back(0); island.push_back(size() - 1);
+
+        uint32_t slot;
+        if (!freeSlots.empty()) {
+            slot = freeSlots.back();
+            freeSlots.pop_back();
+        } else {
+            slot = (uint32_t)slotIndex.size();
+            slotIndex.push_back(0);
+            slotGeneration.push_back(0);
+        }
+        slotIndex[slot] = size() - 1;
+        ballSlot.push_back(slot);
+        return size() - 1;
+    }
+
+    // Resizes to n balls with fresh handles (old handles go stale), for
+    // filling the arrays in bulk. New entries are zero; island ids are reset.
+    void Resize(int n)
+    {
+        clear();
+        x.resize(n); y.resize(n);
+        oldx.resize(n); oldy.resize(n);
+        radius.resize(n);
+        sleeping.resize(n); wake.resize(n);
+        color.resize(n);
+        anchorX.resize(n); anchorY.resize(n);
+        restSteps.resize(n); island.resize(n);
+        ballSlot.resize(n);
+
+        for (int i = 0; i < n; i++) {
+            island[i] = i;
+
+            uint32_t slot;
+            if (!freeSlots.empty()) {
+                slot = freeSlots.back();
+                freeSlots.pop_back();
+            } else {
+                slot = (uint32_t)slotIndex.size();
+                slotIndex.push_back(0);
+                slotGeneration.push_back(0);
+            }
+            slotIndex[slot] = i;
+            ballSlot[i] = slot;
+        }
+    }
+
+    // Accepts any struct with x, y, oldx, oldy, radius and color members
+    // (the demos' Circle).
+    template <typename Ball>
+    void push_back(const Ball& b)
+    {
+        Add(b.x, b.y, b.oldx, b.oldy, b.radius, b.color);
+    }
+
+    // Removes particle i in O(1): the last particle moves to index i
+    void Remove(int i)
+    {
+        int last = size() - 1;
+        uint32_t slot = ballSlot[i];
+
+        if (i != last) {
+            x[i] = x[last]; y[i] = y[last];
+            oldx[i] = oldx[last]; oldy[i] = oldy[last];
+            radius[i] = radius[last];
+            sleeping[i] = sleeping[last]; wake[i] = wake[last];
+            color[i] = color[last];
+            anchorX[i] = anchorX[last]; anchorY[i] = anchorY[last];
+            restSteps[i] = restSteps[last]; island[i] = island[last];
+            ballSlot[i] = ballSlot[last];
+            slotIndex[ballSlot[i]] = i;
+        }
+
+        x.pop_back(); y.pop_back();
+        oldx.pop_back(); oldy.pop_back();
+        radius.pop_back();
+        sleeping.pop_back(); wake.pop_back();
+        color.pop_back();
+        anchorX.pop_back(); anchorY.pop_back();
+        restSteps.pop_back(); island.pop_back();
+        ballSlot.pop_back();
+
+        slotGeneration[slot]++;
+        freeSlots.push_back(slot);
+    }
+
+    // Reorders every ball: new index k gets the ball at old index order[k]
+    // (a permutation of 0..size()-1). Handles follow their balls; island
+    // ids, which are ball indices, are renumbered to match (ids of balls
+    // removed since the last sleep update stay as they are).
+    void Permute(const int* order)
+    {
+        int n = size();
+        inverse.resize(n);
+        for (int k = 0; k < n; k++)
+            inverse[order[k]] = k;
+
+        Gather(x, order, scratchScalar); Gather(y, order, scratchScalar);
+        Gather(oldx, order, scratchScalar); Gather(oldy, order, scratchScalar);
+        Gather(radius, order, scratchScalar);
+        Gather(sleeping, order, scratchBytes); Gather(wake, order, scratchBytes);
+        Gather(color, order, scratchWords);
+        Gather(anchorX, order, scratchScalar); Gather(anchorY, order, scratchScalar);
+        Gather(restSteps, order, scratchInts); Gather(island, order, scratchInts);
+        Gather(ballSlot, order, scratchWords);
+
+        for (int i = 0; i < n; i++) {
+            if (island[i] < n)
+                island[i] = inverse[island[i]];
+            slotIndex[ballSlot[i]] = i;
+        }
+    }
+
+    // New index of the ball that was at old index i before the last Permute
+    int PermutedIndex(int i) const { return inverse[i]; }
+
+    ParticleHandle Handle(int i) const
+    {
+        ParticleHandle h;
+        h.slot = ballSlot[i];
+        h.generation = slotGeneration[h.slot];
+        return h;
+    }
+
+    // Current index of a handle's ball, -1 if it was removed
+    int IndexOf(ParticleHandle h) const
+    {
+        if (h.slot >= slotGeneration.size() || slotGeneration[h.slot] != h.generation)
+            return -1;
+        return (int)slotIndex[h.slot];
+    }
+
+    bool Contains(ParticleHandle h) const { return IndexOf(h) >= 0; }
+
+    BasicParticleRef<T> operator[](int i)
+    {
+        BasicParticleRef<T> p = { x[i], y[i], oldx[i], oldy[i], radius[i], color[i] };
+        return p;
+    }
+
+    // Index based iterator, enough for range-for and balls.begin() + i
+    struct iterator
+    {
+        BasicParticleStore* store;
+        int index;
+
+        BasicParticleRef<T> operator*() const { return (*store)[index]; }
+        iterator& operator++() { index++; return *this; }
+        iterator operator+(int n) const { iterator it = { store, index + n }; return it; }
+        bool operator==(const iterator& o) const { return index == o.index; }
+        bool operator!=(const iterator& o) const { return index != o.index; }
+    };
+
+    iterator begin() { iterator it = { this, 0 }; return it; }
+    iterator end() { iterator it = { this, size() }; return it; }
+
+    // Note: moves the last ball to it, so erase inside a loop must not
+    // advance past it
+    void erase(iterator it) { Remove(it.index); }
+
+private:
+    // Permute scratch, kept so reordering does not allocate every time
+    AlignedArray<T> scratchScalar;
+    std::vector<uint8_t> scratchBytes;
+    std::vector<uint32_t> scratchWords;
+    std::vector<int> scratchInts;
+    std::vector<int> inverse;
+
+    // v[k] = old v[order[k]]; the scratch buffer and v trade places and
+    // v keeps its reserved capacity
+    template <typename Array>
+    static void Gather(Array& v, const int* order, Array& scratch)
+    {
+        size_t n = v.size();
+        scratch.reserve(v.capacity());
+        scratch.resize(n);
+        for (size_t k = 0; k < n; k++)
+            scratch[k] = v[order[k]];
+        v.swap(scratch);
+    }
+};
+
+typedef BasicParticleRef<Scalar> ParticleRef;
+typedef BasicParticleStore<Scalar> ParticleStore;
@@ -0,0 +1,336 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <thread>
+
+#ifdef __linux__
+#include <errno.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// ----------------------------
+// Hardware performance counters
+// ----------------------------
+// Wall time says how long a phase took, not why. These counters say whether
+// it is waiting on memory or on branches:
+//
+//     PerfCounters& perf = GlobalPerfCounters();
+//     if (!perf.Open())                   // counts the calling thread
+//         printf("no counters: %s\n", perf.Error());
+//
+//     PerfReading a, b;
+//     perf.Read(a);
+//     world.step(dt);                     // PERF_SCOPE(PERF_INTEGRATE), ...
+//     perf.Read(b);
+//     PerfCounts frame = perf.Delta(a, b);
+//     printf("IPC %.2f\n", frame.Ipc());
+//     printf("narrow phase IPC %.2f\n", perf.phase[PERF_NARROW_PHASE].Ipc());
+//
+// One perf_event_open group per process (cycles leads; instructions,
+// branches, branch misses, L1D read misses and LLC read misses follow), so
+// all six are scheduled together and their ratios are exact even when the
+// kernel multiplexes the PMU - counts are scaled by enabled / running time.
+// Only user space is counted (kernel.perf_event_paranoid <= 2 allows that
+// for one's own threads). Events the CPU or hypervisor lacks are left out
+// (Has() is false) instead of failing the whole group.
+//
+// Counters follow the thread that called Open(): work the thread pool's
+// workers do is not counted. Measure with one thread, or read the numbers
+// as the calling thread's share.
+//
+// Build with -DENGINE_PERF to put PERF_SCOPE markers around the engine's
+// phases; each reads the group on entry and exit (two read() calls) and
+// adds the difference to phase[]. Without the define the markers compile
+// to nothing, and Open() / Read() still work for whole-frame counts.
+// Other platforms get the same interface; Open() returns false.
+
+enum PerfPhase
+{
+    PERF_INTEGRATE,
+    PERF_BROADPHASE,
+    PERF_NARROW_PHASE,
+    PERF_CONSTRAINT,
+    PERF_RENDER,
+    PERF_PHASE_COUNT
+};
+
+enum PerfEvent
+{
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_BRANCHES,
+    PERF_BRANCH_MISSES,
+    PERF_L1D_MISSES,
+    PERF_LLC_MISSES,
+    PERF_EVENT_COUNT
+};
+
+inline const char* PerfPhaseName(int phase)
+{
+    static const char* const names[PERF_PHASE_COUNT] = {
+        "integrate", "broadphase", "narrow phase", "constraint", "render"
+    };
+    return names[phase];
+}
+
+inline const char* PerfEventName(int event)
+{
+    static const char* const names[PERF_EVENT_COUNT] = {
+        "cycles", "instructions", "branches", "branch_misses", "l1d_misses", "llc_misses"
+    };
+    return names[event];
+}
+
+// Raw group read: running totals since Open()
+struct PerfReading
+{
+    uint64_t enabled = 0, running = 0;      // ns the group existed / was on the PMU
+    uint64_t value[PERF_EVENT_COUNT] = {};
+};
+
+// Event counts of one interval (or a sum of intervals), scaled for
+// multiplexing. The ratios return -1 when an input was not counted.
+struct PerfCounts
+{
+    double value[PERF_EVENT_COUNT] = {};
+    bool counted[PERF_EVENT_COUNT] = {};
+
+    void Add(const PerfCounts& o)
+    {
+        for (int e = 0; e < PERF_EVENT_COUNT; e++) {
+            value[e] += o.value[e];
+            counted[e] = counted[e] || o.counted[e];
+        }
+    }
+
+    // value[a] / value[b], -1 if either is missing or b is zero
+    double Ratio(int a, int b) const
+    {
+        if (!counted[a] || !counted[b] || value[b] <= 0.0)
+            return -1.0;
+        return value[a] / value[b];
+    }
+
+    double Ipc() const { return Ratio(PERF_INSTRUCTIONS, PERF_CYCLES); }
+
+    // Misses per 1000 instructions (event = PERF_L1D_MISSES / PERF_LLC_MISSES)
+    double Mpki(int event) const
+    {
+        double r = Ratio(event, PERF_INSTRUCTIONS);
+        return r < 0.0 ? r : r * 1000.0;
+    }
+
+    // Mispredicted share of all branches, in percent
+    double BranchMissPercent() const
+    {
+        double r = Ratio(PERF_BRANCH_MISSES, PERF_BRANCHES);
+        return r < 0.0 ? r : r * 100.0;
+    }
+};
+
+class PerfCounters
+{
+public:
+    // Totals of every PERF_SCOPE since Open() / ResetPhases()
+    PerfCounts phase[PERF_PHASE_COUNT];
+    long long phaseCalls[PERF_PHASE_COUNT] = {};
+
+    PerfCounters()
+    {
+        for (int e = 0; e < PERF_EVENT_COUNT; e++) {
+            fd[e] = -1;
+            slot[e] = -1;
+        }
+    }
+
+    ~PerfCounters() { Close(); }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    bool IsOpen() const { return fd[PERF_CYCLES] >= 0; }
+    bool Has(int event) const { return slot[event] >= 0; }
+    const char* Error() const { return error.c_str(); }
+
+    // True on the thread the counters count (PERF_SCOPE skips the others)
+    bool OnOwnerThread() const { return IsOpen() && std::this_thread::get_id() == owner; }
+
+    void ResetPhases()
+    {
+        for (int p = 0; p < PERF_PHASE_COUNT; p++) {
+            phase[p] = PerfCounts();
+            phaseCalls[p] = 0;
+        }
+    }
+
+    // Counts of b - a, scaled by the share of the interval the group
+    // actually ran
+    PerfCounts Delta(const PerfReading& a, const PerfReading& b) const
+    {
+        PerfCounts c;
+        uint64_t running = b.running - a.running;
+        double scale = running > 0 ? (double)(b.enabled - a.enabled) / (double)running : 0.0;
+        for (int e = 0; e < PERF_EVENT_COUNT; e++) {
+            if (!Has(e))
+                continue;
+            c.value[e] = (double)(b.value[e] - a.value[e]) * scale;
+            c.counted[e] = running > 0;
+        }
+        return c;
+    }
+
+#ifdef __linux__
+    bool Open()
+    {
+        if (IsOpen())
+            return true;
+        ResetPhases();
+
+        static const struct { uint32_t type; uint64_t config; } events[PERF_EVENT_COUNT] = {
+            { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+            { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+            { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS },
+            { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+            { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+            { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+        };
+
+        opened = 0;
+        for (int e = 0; e < PERF_EVENT_COUNT; e++) {
+            perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = events[e].type;
+            attr.config = events[e].config;
+            attr.disabled = (e == PERF_CYCLES);      // the leader starts the group
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                               PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+            int group = (e == PERF_CYCLES) ? -1 : fd[PERF_CYCLES];
+            fd[e] = (int)syscall(__NR_perf_event_open, &attr, 0, -1, group, 0);
+            if (fd[e] < 0) {
+                if (e == PERF_CYCLES) {
+                    error = std::string("perf_event_open: ") + strerror(errno);
+                    if (errno == EACCES || errno == EPERM)
+                        error += " (see /proc/sys/kernel/perf_event_paranoid)";
+                    else if (errno == ENOENT || errno == EOPNOTSUPP)
+                        error += " (no hardware PMU, e.g. inside a VM or container)";
+                    return false;
+                }
+                continue;   // optional event, the rest of the group still counts
+            }
+            slot[e] = opened++;
+        }
+
+        owner = std::this_thread::get_id();
+        ioctl(fd[PERF_CYCLES], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(fd[PERF_CYCLES], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        error.clear();
+        return true;
+    }
+
+    void Close()
+    {
+        for (int e = PERF_EVENT_COUNT - 1; e >= 0; e--) {
+            if (fd[e] >= 0)
+                close(fd[e]);
+            fd[e] = -1;
+            slot[e] = -1;
+        }
+        opened = 0;
+    }
+
+    // Current totals of the group; false if it is not open
+    bool Read(PerfReading& r) const
+    {
+        if (!IsOpen())
+            return false;
+
+        // nr, time enabled, time running, one value per opened event
+        uint64_t buffer[3 + PERF_EVENT_COUNT];
+        ssize_t bytes = read(fd[PERF_CYCLES], buffer, sizeof(buffer));
+        if (bytes < (ssize_t)(3 * sizeof(uint64_t)))
+            return false;
+
+        r.enabled = buffer[1];
+        r.running = buffer[2];
+        for (int e = 0; e < PERF_EVENT_COUNT; e++)
+            r.value[e] = (slot[e] >= 0 && slot[e] < (int)buffer[0]) ? buffer[3 + slot[e]] : 0;
+        return true;
+    }
+#else
+    bool Open()
+    {
+        error = "hardware counters need Linux perf_event_open";
+        return false;
+    }
+
+    void Close() {}
+
+    bool Read(PerfReading&) const { return false; }
+#endif
+
+private:
+    int fd[PERF_EVENT_COUNT];
+    int slot[PERF_EVENT_COUNT];     // position in the group read, -1 = not counted
+    int opened = 0;
+    std::thread::id owner;
+    std::string error;
+};
+
+inline PerfCounters& GlobalPerfCounters()
+{
+    static PerfCounters counters;
+    return counters;
+}
+
+#ifdef ENGINE_PERF
+
+struct PerfScope
+{
+    int phase;
+    bool active;
+    PerfReading begin;
+
+    explicit PerfScope(int p) : phase(p)
+    {
+        PerfCounters& perf = GlobalPerfCounters();
+        active = perf.OnOwnerThread() && perf.Read(begin);
+    }
+
+    ~PerfScope()
+    {
+        if (!active)
+            return;
+        PerfCounters& perf = GlobalPerfCounters();
+        PerfReading end;
+        if (perf.Read(end)) {
+            perf.phase[phase].Add(perf.Delta(begin, end));
+            perf.phaseCalls[phase]++;
+        }
+    }
+
+    PerfScope(const PerfScope&) = delete;
+    PerfScope& operator=(const PerfScope&) = delete;
+};
+
+#define PERF_CONCAT2(a, b) a##b
+#define PERF_CONCAT(a, b) PERF_CONCAT2(a, b)
+
+// Counts the rest of the enclosing block into GlobalPerfCounters().phase[p]
+#define PERF_SCOPE(p) PerfScope PERF_CONCAT(perfScope, __LINE__)(p)
+
+#else
+
+#define PERF_SCOPE(p) ((void)0)
+
+#endif
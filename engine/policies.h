@@ -0,0 +1,155 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include "particle_store.h"
+#include "particle_physics.h"
+#include "simd_collide.h"
+#include "world_config.h"
+
+// ----------------------------
+// Simulation policies
+// ----------------------------
+// BasicWorld<T, Constraint, Integrator, Response> is put together from three
+// small policy types, picked at compile time. Each one is a plain struct
+// whose functions the world calls directly, so they inline into the substep
+// loop - no virtual calls, no per-ball switch.
+//
+//   Constraint  keeps balls in their container, once per substep
+//   Integrator  moves balls forward, once per step
+//   Response    resolves one touching pair, or a batch of candidate pairs
+//
+// A new container shape is one struct with a constructor taking the
+// WorldConfig and an Apply function:
+//
+//     struct FloorOnly
+//     {
+//         explicit FloorOnly(const WorldConfig&) {}
+//
+//         template <typename T>
+//         void Apply(BasicParticleStore<T>& p, T elasticity) const
+//         {
+//             for (int i = 0; i < p.size(); i++)
+//                 if (p.y[i] > 600 - p.radius[i])
+//                     ...
+//         }
+//     };
+//
+//     typedef BasicWorld<double, FloorOnly> FloorWorld;
+//
+// Shape parameters known at compile time go in a struct of constexpr
+// members, see CircleContainer / BoxContainer.
+
+// ----------------------------
+// Constraint policies
+// ----------------------------
+
+// Shape chosen at run time from WorldConfig::container (the default, and
+// what the plain World uses). One switch per substep, not per ball.
+struct ConfigContainer
+{
+    ContainerShape shape;
+    double x, y, radius;
+    double width, height;
+
+    explicit ConfigContainer(const WorldConfig& cfg)
+        : shape(cfg.container), x(cfg.containerX), y(cfg.containerY),
+          radius(cfg.containerRadius), width(cfg.boxWidth), height(cfg.boxHeight)
+    {
+    }
+
+    template <typename T>
+    void Apply(BasicParticleStore<T>& p, T elasticity) const
+    {
+        switch (shape) {
+        case CONTAINER_CIRCLE:
+            ApplyCircularConstraints(p, (T)x, (T)y, (T)radius, elasticity);
+            break;
+        case CONTAINER_BOX:
+            ApplyBoxConstraints(p, (T)width, (T)height, elasticity);
+            break;
+        case CONTAINER_NONE:
+            break;
+        }
+    }
+};
+
+// Circle fixed at compile time. Shape has constexpr x, y and radius:
+//
+//     struct Container { static constexpr double x = 300, y = 300, radius = 250; };
+//     typedef BasicWorld<Scalar, CircleContainer<Container> > DemoWorld;
+template <typename Shape>
+struct CircleContainer
+{
+    static_assert(Shape::radius > 0, "container radius must be positive");
+
+    explicit CircleContainer(const WorldConfig&) {}
+
+    template <typename T>
+    void Apply(BasicParticleStore<T>& p, T elasticity) const
+    {
+        ApplyCircularConstraints(p, (T)Shape::x, (T)Shape::y, (T)Shape::radius, elasticity);
+    }
+};
+
+// Walls at x = 0, Shape::width and y = 0, Shape::height
+template <typename Shape>
+struct BoxContainer
+{
+    static_assert(Shape::width > 0 && Shape::height > 0, "box must have a size");
+
+    explicit BoxContainer(const WorldConfig&) {}
+
+    template <typename T>
+    void Apply(BasicParticleStore<T>& p, T elasticity) const
+    {
+        ApplyBoxConstraints(p, (T)Shape::width, (T)Shape::height, elasticity);
+    }
+};
+
+// No container at all
+struct OpenContainer
+{
+    explicit OpenContainer(const WorldConfig&) {}
+
+    template <typename T>
+    void Apply(BasicParticleStore<T>&, T) const {}
+};
+
+// ----------------------------
+// Integrator policies
+// ----------------------------
+
+// Time-corrected Verlet (UpdateCircles). gravity is already scaled by dt^2,
+// velocityScale is dt / previous dt.
+struct VerletIntegrator
+{
+    template <typename T>
+    static void Integrate(BasicParticleStore<T>& p, T gravity, T velocityScale,
+                          const uint8_t* sleeping)
+    {
+        UpdateCircles(p, gravity, velocityScale, sleeping);
+    }
+};
+
+// ----------------------------
+// Collision response policies
+// ----------------------------
+
+// Equal-mass elastic response with position correction, batched through
+// the SIMD narrow phase
+struct ElasticResponse
+{
+    template <typename T>
+    static bool Resolve(BasicParticleStore<T>& p, int a, int b, T elasticity)
+    {
+        return ResolveBallCollision(p, a, b, elasticity);
+    }
+
+    template <typename T>
+    static int ResolveBatch(BasicParticleStore<T>& p, const int* pairs, int pairCount,
+                            T elasticity, std::vector<int>& scratch)
+    {
+        return ResolveBallCollisionsSimd(p, pairs, pairCount, elasticity, scratch);
+    }
+};
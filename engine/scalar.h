@@ -0,0 +1,18 @@
+#pragma once
+
+// ----------------------------
+// Engine scalar type
+// ----------------------------
+// The engine is templated on its floating point type (BasicWorld<float>,
+// BasicWorld<double>, ...). The plain names - World, ParticleStore, ... -
+// use Scalar, picked at compile time:
+//
+//     g++ ... -DENGINE_FLOAT      // float32: twice the SIMD lanes, half the bytes
+//
+// The default stays double, the reference build. Configuration (WorldConfig)
+// and query arguments are always double and converted on the way in.
+#ifdef ENGINE_FLOAT
+typedef float Scalar;
+#else
+typedef double Scalar;
+#endif
@@ -0,0 +1,194 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <memory>
+#include "world.h"
+
+// ----------------------------
+// Scenario presets
+// ----------------------------
+// Named, reproducible world setups for the benchmark and headless tools.
+// The small ones rebuild the SDL demos exactly (same container, same spawn
+// line); the stress ones fill a container sized to the ball count with a
+// lattice of balls and run a few warmup steps - the balls are still
+// falling when measuring starts, not a resting pile. To measure a settled
+// pile, settle it once with headless --save and start from the world file.
+//
+// Spawning uses its own tiny generator instead of rand(), so a scenario
+// places the same balls on every platform and compiler.
+
+struct ScenarioRng
+{
+    uint32_t state;
+
+    explicit ScenarioRng(uint32_t seed) : state(seed ? seed : 1u) {}
+
+    // xorshift32
+    uint32_t Next()
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    int Range(int n) { return (int)(Next() % (uint32_t)n); }
+};
+
+struct ScenarioInfo
+{
+    const char* name;
+    const char* description;
+    int ballCount;
+    int warmupSteps;    // steps run before measuring
+    int steps;          // measured steps
+};
+
+static const ScenarioInfo SCENARIOS[] = {
+    { "two_ball",       "collision.cpp: two radius-40 balls in the container", 2,       0,  6000 },
+    { "n_collision",    "n_collision.cpp: 200 balls, radius 6-20",             200,     0,  2000 },
+    { "color_ball",     "color_ball.cpp: 300 balls, radius 6-15",              300,     0,  2000 },
+    { "sleep_pile",     "n_collision with sleeping, pile settled first",       200,     3000, 2000 },
+    { "fast_spray",     "1000 radius-6 balls up to 1500 px/s, 2 substeps + CCD", 1000,  0,  600 },
+    { "mixed_radii",    "open world, 10k radius 2-5 balls around 25 radius 40-60", 10025, 0, 300 },
+    { "stress_10k",     "10k balls, radius 6-20, lattice + 60 warmup steps",   10000,   60, 200 },
+    { "stress_100k",    "100k balls, radius 6-20, lattice + 20 warmup steps",  100000,  20, 40 },
+    { "stress_1m",      "1M balls, radius 6-20, lattice + 5 warmup steps",     1000000, 5,  10 },
+};
+
+static const int SCENARIO_COUNT = sizeof(SCENARIOS) / sizeof(SCENARIOS[0]);
+
+inline const ScenarioInfo* FindScenario(const char* name)
+{
+    for (int i = 0; i < SCENARIO_COUNT; i++)
+        if (strcmp(SCENARIOS[i].name, name) == 0)
+            return &SCENARIOS[i];
+    return nullptr;
+}
+
+// Demo container: 250 px circle in the middle of the 600x600 window
+inline WorldConfig DemoConfig(int substeps, int threads)
+{
+    WorldConfig config;
+    config.gravity = 0.5 * 60.0 * 60.0;
+    config.elasticity = 0.9;
+    config.substeps = substeps;
+    config.container = CONTAINER_CIRCLE;
+    config.containerX = 300.0;
+    config.containerY = 300.0;
+    config.containerRadius = 250.0;
+    config.threads = threads;
+    return config;
+}
+
+// The SDL demos' spawn line: count balls along the diagonal from (300, 100),
+// 2 px apart, radius 6 to 6 + radiusRange - 1
+template <typename WorldType>
+inline void SpawnDemoLine(WorldType& world, int count, int radiusRange, ScenarioRng& rng)
+{
+    world.particles().reserve(world.ballCount() + count);
+    for (int i = 0; i < count; i++)
+        world.addBall(300 + i * 2, 100 + i * 2, 6 + rng.Range(radiusRange));
+}
+
+// Fills a circular container sized for ballCount balls at ~50% packing,
+// balls on a square lattice
+template <typename T = Scalar>
+inline std::unique_ptr<BasicWorld<T> > CreateStressWorld(int ballCount, int threads, uint32_t seed)
+{
+    double averageRadius = 13.0;
+    double containerRadius = sqrt(2.0 * ballCount) * averageRadius;
+    if (containerRadius < 250.0)
+        containerRadius = 250.0;
+
+    WorldConfig config = DemoConfig(8, threads);
+    config.containerX = containerRadius;
+    config.containerY = containerRadius;
+    config.containerRadius = containerRadius;
+
+    std::unique_ptr<BasicWorld<T> > world(new BasicWorld<T>(config));
+    world->particles().reserve(ballCount);
+
+    ScenarioRng rng(seed);
+    int perRow = (int)ceil(sqrt((double)ballCount));
+    double spacing = containerRadius * 1.4 / perRow;
+    double start = containerRadius - containerRadius * 0.7 + spacing * 0.5;
+    for (int i = 0; i < ballCount; i++) {
+        double x = start + (i % perRow) * spacing;
+        double y = start + (i / perRow) * spacing;
+        world->addBall(x, y, 6 + rng.Range(15));
+    }
+    return world;
+}
+
+// Builds the named scenario, or returns null for an unknown name
+template <typename T = Scalar>
+inline std::unique_ptr<BasicWorld<T> > CreateScenario(const char* name, int threads, uint32_t seed = 1)
+{
+    std::unique_ptr<BasicWorld<T> > world;
+    ScenarioRng rng(seed);
+
+    if (strcmp(name, "two_ball") == 0) {
+        world.reset(new BasicWorld<T>(DemoConfig(4, threads)));
+        world->particles().Add(200, 100, 300, 100, 40, 0xffffffff);
+        world->particles().Add(350, 100, 350, 100, 40, 0xffffffff);
+    }
+    else if (strcmp(name, "n_collision") == 0 || strcmp(name, "color_ball") == 0 ||
+             strcmp(name, "sleep_pile") == 0) {
+        bool color = (strcmp(name, "color_ball") == 0);
+        int count = color ? 300 : 200;
+        int radiusRange = color ? 10 : 15;
+
+        WorldConfig config = DemoConfig(8, threads);
+        config.sleeping = (strcmp(name, "sleep_pile") == 0);
+        world.reset(new BasicWorld<T>(config));
+        SpawnDemoLine(*world, count, radiusRange, rng);
+    }
+    else if (strcmp(name, "fast_spray") == 0) {
+        // Small balls fired in every direction on a lattice filling the
+        // container: they tunnel without ccd at this substep count
+        WorldConfig config = DemoConfig(2, threads);
+        config.ccd = true;
+        world.reset(new BasicWorld<T>(config));
+        world->particles().reserve(1000);
+        for (int k = 0; world->ballCount() < 1000 && k < 40 * 40; k++) {
+            double x = 300 + (k % 40 - 19.5) * 12.5, y = 300 + (k / 40 - 19.5) * 12.5;
+            if ((x - 300) * (x - 300) + (y - 300) * (y - 300) > 235.0 * 235.0)
+                continue;
+            double vx = rng.Range(3001) - 1500.0, vy = rng.Range(3001) - 1500.0;
+            world->addBall(x, y, vx, vy, 1.0 / 60.0, 6);
+        }
+    }
+    else if (strcmp(name, "mixed_radii") == 0) {
+        // No container, no gravity: a drifting cloud of grit around a
+        // few boulders that keeps spreading (a uniform grid sized for the
+        // boulders puts dozens of grains in every cell)
+        WorldConfig config = DemoConfig(4, threads);
+        config.container = CONTAINER_NONE;
+        config.gravity = 0.0;
+        world.reset(new BasicWorld<T>(config));
+        world->particles().reserve(10025);
+        double bx[25], by[25], br[25];
+        for (int k = 0; k < 25; k++) {
+            bx[k] = 150 + (k % 5) * 250;
+            by[k] = 150 + (k / 5) * 250;
+            br[k] = 40 + rng.Range(21);
+            world->addBall(bx[k], by[k], rng.Range(61) - 30.0, rng.Range(61) - 30.0, 1.0 / 60.0, br[k]);
+        }
+        for (int k = 0; world->ballCount() < 10025 && k < 130 * 130; k++) {
+            double x = 30 + (k % 130) * 10.0, y = 30 + (k / 130) * 10.0;
+            bool free = true;
+            for (int b = 0; b < 25 && free; b++)
+                free = (x - bx[b]) * (x - bx[b]) + (y - by[b]) * (y - by[b]) > (br[b] + 6) * (br[b] + 6);
+            if (!free)
+                continue;
+            world->addBall(x, y, rng.Range(121) - 60.0, rng.Range(121) - 60.0, 1.0 / 60.0, 2 + rng.Range(4));
+        }
+    }
+    else if (const ScenarioInfo* info = FindScenario(name)) {
+        world = CreateStressWorld<T>(info->ballCount, threads, seed);
+    }
+    return world;
+}
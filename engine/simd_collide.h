@@ -0,0 +1,336 @@
+#pragma once
+
+#include <vector>
+#include <math.h>
+#include "particle_store.h"
+#include "particle_physics.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define SIMD_LANES 4
+#define SIMD_LANES_FLOAT 8
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SIMD_LANES 2
+#define SIMD_LANES_FLOAT 4
+#else
+#define SIMD_LANES 1
+#define SIMD_LANES_FLOAT 1
+#endif
+
+// ----------------------------
+// SIMD narrow phase
+// ----------------------------
+// Takes the candidate pairs from the broadphase and works on them
+// Simd<T>::LANES at a time (AVX2: 4 doubles or 8 floats, SSE2: 2 or 4):
+//
+//   1. Cull: squared distance vs squared radius sum for every lane, no sqrt,
+//      no branches. Only the lanes that really overlap are kept.
+//   2. Resolve: survivors are regrouped LANES at a time. If a group
+//      touches 2*LANES different balls, the position correction and
+//      restitution run in vector registers with masks instead of branches.
+//      A group that shares a ball falls back to the scalar path so the
+//      update order (Gauss-Seidel) is the same as one pair at a time.
+//
+// The cull sees the positions from before the batch. A pair that an earlier
+// correction pushes into contact during the same pass is picked up on the
+// next substep instead.
+//
+// Build with -mavx2 to get the 256 bit version; x86-64 always has SSE2.
+
+// Register type and operations per scalar type. LANES == 1 means no SIMD.
+template <typename T>
+struct Simd
+{
+    enum { LANES = 1 };
+};
+
+#if SIMD_LANES > 1
+
+#if SIMD_LANES == 4
+template <>
+struct Simd<double>
+{
+    enum { LANES = 4 };
+    typedef __m256d V;
+    static V Set1(double v) { return _mm256_set1_pd(v); }
+    static V Add(V a, V b) { return _mm256_add_pd(a, b); }
+    static V Sub(V a, V b) { return _mm256_sub_pd(a, b); }
+    static V Mul(V a, V b) { return _mm256_mul_pd(a, b); }
+    static V Div(V a, V b) { return _mm256_div_pd(a, b); }
+    static V Sqrt(V a) { return _mm256_sqrt_pd(a); }
+    static V Less(V a, V b) { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+    static V LessEq(V a, V b) { return _mm256_cmp_pd(a, b, _CMP_LE_OQ); }
+    static V And(V a, V b) { return _mm256_and_pd(a, b); }
+    static V Select(V mask, V yes, V no) { return _mm256_blendv_pd(no, yes, mask); }
+    static int Mask(V m) { return _mm256_movemask_pd(m); }
+    static void Store(double* out, V a) { _mm256_storeu_pd(out, a); }
+    static V Gather(const double* base, const int* idx)
+    {
+        __m128i vi = _mm_loadu_si128((const __m128i*)idx);
+        __m256d all = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+        return _mm256_mask_i32gather_pd(_mm256_setzero_pd(), base, vi, all, 8);
+    }
+};
+
+template <>
+struct Simd<float>
+{
+    enum { LANES = 8 };
+    typedef __m256 V;
+    static V Set1(float v) { return _mm256_set1_ps(v); }
+    static V Add(V a, V b) { return _mm256_add_ps(a, b); }
+    static V Sub(V a, V b) { return _mm256_sub_ps(a, b); }
+    static V Mul(V a, V b) { return _mm256_mul_ps(a, b); }
+    static V Div(V a, V b) { return _mm256_div_ps(a, b); }
+    static V Sqrt(V a) { return _mm256_sqrt_ps(a); }
+    static V Less(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+    static V LessEq(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+    static V And(V a, V b) { return _mm256_and_ps(a, b); }
+    static V Select(V mask, V yes, V no) { return _mm256_blendv_ps(no, yes, mask); }
+    static int Mask(V m) { return _mm256_movemask_ps(m); }
+    static void Store(float* out, V a) { _mm256_storeu_ps(out, a); }
+    static V Gather(const float* base, const int* idx)
+    {
+        __m256i vi = _mm256_loadu_si256((const __m256i*)idx);
+        __m256 all = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        return _mm256_mask_i32gather_ps(_mm256_setzero_ps(), base, vi, all, 4);
+    }
+};
+#else
+template <>
+struct Simd<double>
+{
+    enum { LANES = 2 };
+    typedef __m128d V;
+    static V Set1(double v) { return _mm_set1_pd(v); }
+    static V Add(V a, V b) { return _mm_add_pd(a, b); }
+    static V Sub(V a, V b) { return _mm_sub_pd(a, b); }
+    static V Mul(V a, V b) { return _mm_mul_pd(a, b); }
+    static V Div(V a, V b) { return _mm_div_pd(a, b); }
+    static V Sqrt(V a) { return _mm_sqrt_pd(a); }
+    static V Less(V a, V b) { return _mm_cmplt_pd(a, b); }
+    static V LessEq(V a, V b) { return _mm_cmple_pd(a, b); }
+    static V And(V a, V b) { return _mm_and_pd(a, b); }
+    static V Select(V mask, V yes, V no)
+    {
+        // SSE2 has no blendv
+        return _mm_or_pd(_mm_and_pd(mask, yes), _mm_andnot_pd(mask, no));
+    }
+    static int Mask(V m) { return _mm_movemask_pd(m); }
+    static void Store(double* out, V a) { _mm_storeu_pd(out, a); }
+    static V Gather(const double* base, const int* idx)
+    {
+        return _mm_set_pd(base[idx[1]], base[idx[0]]);
+    }
+};
+
+template <>
+struct Simd<float>
+{
+    enum { LANES = 4 };
+    typedef __m128 V;
+    static V Set1(float v) { return _mm_set1_ps(v); }
+    static V Add(V a, V b) { return _mm_add_ps(a, b); }
+    static V Sub(V a, V b) { return _mm_sub_ps(a, b); }
+    static V Mul(V a, V b) { return _mm_mul_ps(a, b); }
+    static V Div(V a, V b) { return _mm_div_ps(a, b); }
+    static V Sqrt(V a) { return _mm_sqrt_ps(a); }
+    static V Less(V a, V b) { return _mm_cmplt_ps(a, b); }
+    static V LessEq(V a, V b) { return _mm_cmple_ps(a, b); }
+    static V And(V a, V b) { return _mm_and_ps(a, b); }
+    static V Select(V mask, V yes, V no)
+    {
+        return _mm_or_ps(_mm_and_ps(mask, yes), _mm_andnot_ps(mask, no));
+    }
+    static int Mask(V m) { return _mm_movemask_ps(m); }
+    static void Store(float* out, V a) { _mm_storeu_ps(out, a); }
+    static V Gather(const float* base, const int* idx)
+    {
+        return _mm_set_ps(base[idx[3]], base[idx[2]], base[idx[1]], base[idx[0]]);
+    }
+};
+#endif
+
+#endif // SIMD_LANES > 1
+
+// Lanes that overlap: 0 < dist^2 < (ra + rb)^2
+template <typename T>
+inline typename Simd<T>::V SimdOverlapMask(const BasicParticleStore<T>& p, const int* ia, const int* ib)
+{
+    typedef Simd<T> S;
+    typename S::V dx = S::Sub(S::Gather(p.x.data(), ib), S::Gather(p.x.data(), ia));
+    typename S::V dy = S::Sub(S::Gather(p.y.data(), ib), S::Gather(p.y.data(), ia));
+    typename S::V minDist = S::Add(S::Gather(p.radius.data(), ia), S::Gather(p.radius.data(), ib));
+
+    typename S::V dist2 = S::Add(S::Mul(dx, dx), S::Mul(dy, dy));
+    typename S::V overlap = S::Less(dist2, S::Mul(minDist, minDist));
+    typename S::V nonZero = S::Less(S::Set1(0), dist2);
+    return S::And(overlap, nonZero);
+}
+
+// True if no ball appears twice among the group's pairs
+template <int LANES>
+inline bool PairsDisjoint(const int* ia, const int* ib)
+{
+    int ids[2 * LANES];
+    for (int k = 0; k < LANES; k++) {
+        ids[2*k] = ia[k];
+        ids[2*k + 1] = ib[k];
+    }
+    for (int i = 0; i < 2 * LANES; i++)
+        for (int j = i + 1; j < 2 * LANES; j++)
+            if (ids[i] == ids[j])
+                return false;
+    return true;
+}
+
+// Resolves LANES pairs with no ball in common, all in registers.
+// Returns the number of lanes that were overlapping.
+template <typename T>
+inline int ResolveBallCollisionLanes(BasicParticleStore<T>& p, const int* ia, const int* ib,
+                                     T elasticity)
+{
+    typedef Simd<T> S;
+    typedef typename S::V V;
+    const int LANES = S::LANES;
+
+    V ax = S::Gather(p.x.data(), ia), ay = S::Gather(p.y.data(), ia);
+    V bx = S::Gather(p.x.data(), ib), by = S::Gather(p.y.data(), ib);
+    V aox = S::Gather(p.oldx.data(), ia), aoy = S::Gather(p.oldy.data(), ia);
+    V box = S::Gather(p.oldx.data(), ib), boy = S::Gather(p.oldy.data(), ib);
+    V minDist = S::Add(S::Gather(p.radius.data(), ia), S::Gather(p.radius.data(), ib));
+
+    // Overlap test again on current positions (earlier groups may have moved them)
+    V dx = S::Sub(bx, ax);
+    V dy = S::Sub(by, ay);
+    V dist2 = S::Add(S::Mul(dx, dx), S::Mul(dy, dy));
+    V zero = S::Set1(0);
+    V hit = S::And(S::Less(dist2, S::Mul(minDist, minDist)), S::Less(zero, dist2));
+
+    int hitMask = S::Mask(hit);
+    if (hitMask == 0)
+        return 0;
+
+    // Normalized collision normal (garbage in masked-off lanes, never stored)
+    V dist = S::Sqrt(dist2);
+    V invDist = S::Div(S::Set1(1), dist);
+    V nx = S::Mul(dx, invDist);
+    V ny = S::Mul(dy, invDist);
+
+    // -------- POSITION CORRECTION --------
+    V correction = S::Mul(S::Sub(minDist, dist), S::Set1(T(0.5)));
+    V cx = S::Mul(nx, correction);
+    V cy = S::Mul(ny, correction);
+
+    V nax = S::Select(hit, S::Sub(ax, cx), ax);
+    V nay = S::Select(hit, S::Sub(ay, cy), ay);
+    V nbx = S::Select(hit, S::Add(bx, cx), bx);
+    V nby = S::Select(hit, S::Add(by, cy), by);
+
+    // -------- VELOCITY (VERLET STYLE) --------
+    V avx = S::Sub(nax, aox), avy = S::Sub(nay, aoy);
+    V bvx = S::Sub(nbx, box), bvy = S::Sub(nby, boy);
+
+    V velAlongNormal = S::Add(S::Mul(S::Sub(bvx, avx), nx),
+                              S::Mul(S::Sub(bvy, avy), ny));
+
+    // Approaching lanes get the elastic response, separating lanes keep
+    // their old positions untouched
+    V approach = S::And(hit, S::LessEq(velAlongNormal, zero));
+    V impulse = S::Mul(velAlongNormal, S::Set1(-(1 + elasticity) * T(0.5)));
+    V ix = S::Mul(impulse, nx);
+    V iy = S::Mul(impulse, ny);
+
+    V naox = S::Select(approach, S::Sub(nax, S::Sub(avx, ix)), aox);
+    V naoy = S::Select(approach, S::Sub(nay, S::Sub(avy, iy)), aoy);
+    V nbox = S::Select(approach, S::Sub(nbx, S::Add(bvx, ix)), box);
+    V nboy = S::Select(approach, S::Sub(nby, S::Add(bvy, iy)), boy);
+
+    // Scatter back the lanes that changed
+    T out[8][LANES];
+    S::Store(out[0], nax); S::Store(out[1], nay);
+    S::Store(out[2], nbx); S::Store(out[3], nby);
+    S::Store(out[4], naox); S::Store(out[5], naoy);
+    S::Store(out[6], nbox); S::Store(out[7], nboy);
+
+    int hits = 0;
+    for (int k = 0; k < LANES; k++) {
+        if (!(hitMask & (1 << k)))
+            continue;
+        int a = ia[k], b = ib[k];
+        p.x[a] = out[0][k]; p.y[a] = out[1][k];
+        p.x[b] = out[2][k]; p.y[b] = out[3][k];
+        p.oldx[a] = out[4][k]; p.oldy[a] = out[5][k];
+        p.oldx[b] = out[6][k]; p.oldy[b] = out[7][k];
+        hits++;
+    }
+    return hits;
+}
+
+// ----------------------------
+// Batched ball-ball collision
+// ----------------------------
+// pairs holds index pairs back to back: a0, b0, a1, b1, ...
+// survivors is scratch space, reused between calls.
+// Returns the number of pairs that were actually touching.
+template <typename T>
+inline int ResolveBallCollisionsSimd(BasicParticleStore<T>& p, const int* pairs, int pairCount,
+                                     typename BasicParticleStore<T>::Scalar elasticity,
+                                     std::vector<int>& survivors)
+{
+    typedef Simd<T> S;
+    const int LANES = S::LANES;
+
+    if constexpr (LANES > 1) {
+        survivors.clear();
+
+        // 1. Cull LANES candidates at a time on squared distance
+        int k = 0;
+        for (; k + LANES <= pairCount; k += LANES) {
+            int ia[LANES], ib[LANES];
+            for (int l = 0; l < LANES; l++) {
+                ia[l] = pairs[2*(k + l)];
+                ib[l] = pairs[2*(k + l) + 1];
+            }
+
+            int mask = S::Mask(SimdOverlapMask(p, ia, ib));
+            for (int l = 0; l < LANES; l++) {
+                if (mask & (1 << l)) {
+                    survivors.push_back(ia[l]);
+                    survivors.push_back(ib[l]);
+                }
+            }
+        }
+        // Tail
+        for (; k < pairCount; k++) {
+            survivors.push_back(pairs[2*k]);
+            survivors.push_back(pairs[2*k + 1]);
+        }
+
+        // 2. Resolve the survivors
+        int contacts = 0;
+        int survivorCount = (int)survivors.size() / 2;
+        int s = 0;
+        for (; s + LANES <= survivorCount; s += LANES) {
+            int ia[LANES], ib[LANES];
+            for (int l = 0; l < LANES; l++) {
+                ia[l] = survivors[2*(s + l)];
+                ib[l] = survivors[2*(s + l) + 1];
+            }
+
+            if (PairsDisjoint<LANES>(ia, ib)) {
+                contacts += ResolveBallCollisionLanes(p, ia, ib, elasticity);
+            } else {
+                for (int l = 0; l < LANES; l++)
+                    if (ResolveBallCollision(p, ia[l], ib[l], elasticity))
+                        contacts++;
+            }
+        }
+        contacts += ResolveBallCollisions(p, survivors.data() + 2*s, survivorCount - s, elasticity);
+        return contacts;
+    } else {
+        (void)survivors;
+        return ResolveBallCollisions(p, pairs, pairCount, elasticity);
+    }
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include "particle_store.h"
+#include "triple_buffer.h"
+#include "world.h"
+
+// ----------------------------
+// World snapshots for a render thread
+// ----------------------------
+// The physics thread publishes an immutable copy of the drawable state after
+// every tick. Each snapshot carries the positions of this tick and of the
+// tick before, so the render thread can interpolate between the last two
+// ticks even if it skipped some snapshots.
+struct WorldSnapshot
+{
+    long long tick = 0;
+    double time = 0.0;      // seconds, when the tick was published
+
+    AlignedArray<Scalar> x, y;      // this tick
+    AlignedArray<Scalar> prevx, prevy; // previous tick
+    AlignedArray<Scalar> radius;
+    std::vector<uint32_t> color;
+
+    int size() const { return (int)x.size(); }
+};
+
+// Physics side: copies the world into the triple buffer
+struct SnapshotPublisher
+{
+    TripleBuffer<WorldSnapshot> buffer;
+
+    // structureChanged: balls were added or removed since the last publish,
+    // so indices no longer match and this tick is not interpolated. A change
+    // of world.layoutVersion() (removal, reorder) counts the same, so a
+    // Morton reorder never blends one ball's position with another's.
+    template <typename WorldType>
+    void Publish(const WorldType& world, double time, bool structureChanged)
+    {
+        const ParticleStore& p = world.particles();
+        WorldSnapshot& s = buffer.WriteBuffer();
+
+        s.tick = world.stats().steps;
+        s.time = time;
+        s.x.assign(p.x.begin(), p.x.end());
+        s.y.assign(p.y.begin(), p.y.end());
+        s.radius.assign(p.radius.begin(), p.radius.end());
+        s.color.assign(p.color.begin(), p.color.end());
+
+        if (structureChanged || world.layoutVersion() != lastLayout ||
+            lastX.size() != p.x.size()) {
+            s.prevx = s.x;
+            s.prevy = s.y;
+        } else {
+            s.prevx = lastX;
+            s.prevy = lastY;
+        }
+
+        lastX = s.x;
+        lastY = s.y;
+        lastLayout = world.layoutVersion();
+        buffer.Publish();
+    }
+
+private:
+    AlignedArray<Scalar> lastX, lastY;
+    long long lastLayout = -1;
+};
+
+// Render side: positions at prev + (current - prev) * alpha, alpha in [0, 1]
+inline void InterpolateSnapshot(const WorldSnapshot& s, double alpha, ParticleStore& out)
+{
+    if (alpha < 0.0) alpha = 0.0;
+    if (alpha > 1.0) alpha = 1.0;
+
+    int n = s.size();
+    out.x.resize(n);
+    out.y.resize(n);
+    out.oldx.resize(n);
+    out.oldy.resize(n);
+    out.radius.assign(s.radius.begin(), s.radius.end());
+    out.color.assign(s.color.begin(), s.color.end());
+
+    for (int i = 0; i < n; i++) {
+        out.x[i] = s.prevx[i] + (s.x[i] - s.prevx[i]) * alpha;
+        out.y[i] = s.prevy[i] + (s.y[i] - s.prevy[i]) * alpha;
+        out.oldx[i] = s.prevx[i];
+        out.oldy[i] = s.prevy[i];
+    }
+}
@@ -0,0 +1,234 @@
+#pragma once
+
+#include <vector>
+#include <float.h>
+#include <math.h>
+#include "particle_store.h"
+
+// ----------------------------
+// Uniform grid broadphase
+// ----------------------------
+// Every substep the balls are binned into square cells whose side is the
+// largest diameter in the scene. Two balls can then only touch if they sit
+// in the same cell or in one of the 8 cells around it, so instead of testing
+// every pair we only test balls that share a neighbourhood.
+//
+// Binning is a counting sort:
+//   1. count how many balls land in each cell
+//   2. prefix sum the counts -> start offset of every cell
+//   3. scatter the ball indices into one flat array
+// No per-cell vectors, no allocations once the buffers have grown.
+
+// Cell coordinate d (in cells from the origin) clamped to [0, count).
+// Negative, NaN and huge values land in the edge cells instead of
+// overflowing the int conversion.
+inline int GridCellClamp(double d, int count)
+{
+    if (!(d >= 0.0))
+        return 0;
+    if (d >= (double)count)
+        return count - 1;
+    return (int)d;
+}
+
+// Bounds of the balls for sizing a grid. Balls with a NaN or infinite
+// position (an exploding scene, a corrupt file) are left out of the
+// bounds and clamped into an edge cell, and non-finite radii are ignored,
+// so the extent is always finite and the cell size search ends.
+struct GridBounds
+{
+    double minX = 0.0, minY = 0.0;
+    double width = 0.0, height = 0.0;
+    double minRadius = 0.0, maxRadius = 0.0;
+
+    template <typename T>
+    GridBounds(const T* x, const T* y, const T* radius, int n)
+    {
+        double maxX = -HUGE_VAL, maxY = -HUGE_VAL;
+        minX = minY = HUGE_VAL;
+        minRadius = HUGE_VAL;
+        for (int i = 0; i < n; i++) {
+            double r = radius[i];
+            if (isfinite(r)) {
+                if (r < minRadius) minRadius = r;
+                if (r > maxRadius) maxRadius = r;
+            }
+            if (!isfinite((double)x[i]) || !isfinite((double)y[i]))
+                continue;
+            if (x[i] < minX) minX = x[i];
+            if (x[i] > maxX) maxX = x[i];
+            if (y[i] < minY) minY = y[i];
+            if (y[i] > maxY) maxY = y[i];
+        }
+        if (minRadius > maxRadius)
+            minRadius = maxRadius;
+        if (minX > maxX) {
+            minX = maxX = 0.0;
+            minY = maxY = 0.0;
+        }
+
+        // Finite ends can still be more than DBL_MAX apart
+        width = maxX - minX;
+        height = maxY - minY;
+        if (width > DBL_MAX) width = DBL_MAX;
+        if (height > DBL_MAX) height = DBL_MAX;
+    }
+};
+
+// Side of the cells: at least minSize (if that is a usable size), doubled
+// until there are at most maxCells cells over the bounds
+inline double GridCellSize(const GridBounds& b, double minSize, double maxCells)
+{
+    double size = minSize;
+    if (!(size > 0.0) || size > DBL_MAX)
+        size = 1.0;
+    while ((b.width / size + 1.0) * (b.height / size + 1.0) > maxCells)
+        size *= 2.0;
+    return size;
+}
+
+struct SpatialGrid
+{
+    double cellSize = 1.0;
+    double originX = 0.0, originY = 0.0;
+    int cols = 0, rows = 0;
+
+    std::vector<int> cellStart;   // cols*rows + 1 offsets into cellItems
+    std::vector<int> cellItems;   // ball indices, grouped by cell
+    std::vector<int> ballCell;    // cell index of every ball
+
+    // Statistics of the last ForEachPair call
+    long long pairsTested = 0;
+
+    int CellIndex(double x, double y) const
+    {
+        int cx = GridCellClamp((x - originX) / cellSize, cols);
+        int cy = GridCellClamp((y - originY) / cellSize, rows);
+        return cy * cols + cx;
+    }
+
+    // Bin all particles of the store
+    template <typename T>
+    void Build(const BasicParticleStore<T>& p)
+    {
+        Build(p.x.data(), p.y.data(), p.radius.data(), p.size());
+    }
+
+    // Bin n balls given as position / radius arrays (float or double;
+    // the grid itself always works in double)
+    template <typename T>
+    void Build(const T* x, const T* y, const T* radius, int n)
+    {
+        ballCell.resize(n);
+        cellItems.resize(n);
+
+        if (n == 0) {
+            cols = rows = 0;
+            cellStart.assign(1, 0);
+            return;
+        }
+
+        // World bounds and largest radius -> grid extent and cell size
+        GridBounds bounds(x, y, radius, n);
+
+        // A ball flung far away would blow the cell count up; grow the
+        // cells instead so the grid never has many more cells than balls.
+        cellSize = GridCellSize(bounds, 2.0 * bounds.maxRadius, 4.0 * n + 64.0);
+
+        originX = bounds.minX;
+        originY = bounds.minY;
+        cols = (int)(bounds.width / cellSize) + 1;
+        rows = (int)(bounds.height / cellSize) + 1;
+
+        int cellCount = cols * rows;
+        cellStart.assign(cellCount + 1, 0);
+
+        // 1. Count
+        for (int i = 0; i < n; i++) {
+            ballCell[i] = CellIndex(x[i], y[i]);
+            cellStart[ballCell[i] + 1]++;
+        }
+
+        // 2. Prefix sum
+        for (int c = 0; c < cellCount; c++)
+            cellStart[c + 1] += cellStart[c];
+
+        // 3. Scatter (keeps ball order inside each cell)
+        std::vector<int>& cursor = scratch;
+        cursor.assign(cellStart.begin(), cellStart.end() - 1);
+        for (int i = 0; i < n; i++)
+            cellItems[cursor[ballCell[i]]++] = i;
+    }
+
+    // Calls visit(i, j) once for every pair of balls in neighbouring cells.
+    // Only the "forward" half of the neighbourhood is scanned (right, and
+    // the row below) so each pair shows up exactly once.
+    template <typename Visit>
+    void ForEachPair(Visit visit)
+    {
+        pairsTested = ForEachPairInColumns(0, cols, visit);
+    }
+
+    // Same as ForEachPair, restricted to the cells in columns [col0, col1).
+    // Pairs reach at most one column outside the range on either side.
+    // Returns the number of pairs visited.
+    template <typename Visit>
+    long long ForEachPairInColumns(int col0, int col1, Visit visit) const
+    {
+        long long tested = 0;
+
+        static const int offsets[4][2] = { {1, 0}, {-1, 1}, {0, 1}, {1, 1} };
+
+        for (int cy = 0; cy < rows; cy++) {
+            for (int cx = col0; cx < col1; cx++) {
+                int cell = cy * cols + cx;
+                int begin = cellStart[cell];
+                int end = cellStart[cell + 1];
+                if (begin == end)
+                    continue;
+
+                // Pairs inside the cell
+                for (int a = begin; a < end; a++) {
+                    for (int b = a + 1; b < end; b++) {
+                        visit(cellItems[a], cellItems[b]);
+                        tested++;
+                    }
+                }
+
+                // Pairs with the forward neighbours
+                for (int k = 0; k < 4; k++) {
+                    int nx = cx + offsets[k][0];
+                    int ny = cy + offsets[k][1];
+                    if (nx < 0 || nx >= cols || ny >= rows)
+                        continue;
+
+                    int other = ny * cols + nx;
+                    int otherBegin = cellStart[other];
+                    int otherEnd = cellStart[other + 1];
+
+                    for (int a = begin; a < end; a++) {
+                        for (int b = otherBegin; b < otherEnd; b++) {
+                            visit(cellItems[a], cellItems[b]);
+                            tested++;
+                        }
+                    }
+                }
+            }
+        }
+        return tested;
+    }
+
+    // Writes every candidate pair into pairs (a0, b0, a1, b1, ...), in the
+    // same order ForEachPair visits them, for the batched narrow phase.
+    void CollectPairs(std::vector<int>& pairs)
+    {
+        pairs.clear();
+        ForEachPair([&](int a, int b) {
+            pairs.push_back(a);
+            pairs.push_back(b);
+        });
+    }
+
+private:
+    std::vector<int> scratch;
+};
@@ -0,0 +1,321 @@
+#pragma once
+
+#include <math.h>
+#include <algorithm>
+#include <utility>
+#include <vector>
+#include "particle_store.h"
+#include "spatial_grid.h"
+#include "thread_pool.h"
+
+// ----------------------------
+// Spatial queries
+// ----------------------------
+// Point picking, radius range, ray cast and k-nearest over a uniform grid of
+// the current ball positions, instead of a linear scan per query.
+//
+// The grid cells are at least one diameter wide, so a ball can only reach
+// into the 8 cells around the one its center is binned in. Every query only
+// looks at the cells around what it is asking about.
+//
+// Build() once after the positions change (World::query() does this for
+// you), then ask as many questions as needed. Queries are const and safe to
+// run from several threads at once; the *Batch versions do exactly that.
+// Query coordinates are double whatever the store's scalar type.
+
+struct RayHit
+{
+    int ball = -1;          // -1 = nothing hit
+    double distance = 0.0;  // along the ray, 0 if the origin is inside the ball
+};
+
+template <typename T>
+class BasicSpatialQuery
+{
+public:
+    // Probes per thread task in the batched queries
+    int batchChunk = 256;
+
+    void Build(const BasicParticleStore<T>& particles)
+    {
+        p = &particles;
+        grid.Build(particles);
+    }
+
+    // Number of balls the query was built for
+    int size() const { return p ? p->size() : 0; }
+
+    // Ball containing point (x, y), or -1. Lowest index wins when balls
+    // overlap, same as scanning the balls in order.
+    int Pick(double x, double y) const
+    {
+        if (size() == 0)
+            return -1;
+
+        int cx, cy;
+        CellOf(x, y, cx, cy);
+
+        int best = -1;
+        for (int ny = cy - 1; ny <= cy + 1; ny++) {
+            for (int nx = cx - 1; nx <= cx + 1; nx++) {
+                if (nx < 0 || ny < 0 || nx >= grid.cols || ny >= grid.rows)
+                    continue;
+                int cell = ny * grid.cols + nx;
+                for (int k = grid.cellStart[cell]; k < grid.cellStart[cell + 1]; k++) {
+                    int i = grid.cellItems[k];
+                    if (best >= 0 && i > best)
+                        continue;
+                    double dx = p->x[i] - x;
+                    double dy = p->y[i] - y;
+                    if (dx * dx + dy * dy < p->radius[i] * p->radius[i])
+                        best = i;
+                }
+            }
+        }
+        return best;
+    }
+
+    // All balls touching the circle (x, y, radius), in no particular order
+    void QueryRadius(double x, double y, double radius, std::vector<int>& out) const
+    {
+        out.clear();
+        if (size() == 0)
+            return;
+
+        // Ball centers can sit half a cell outside the searched circle
+        double reach = radius + 0.5 * grid.cellSize;
+        int cx0, cy0, cx1, cy1;
+        CellOf(x - reach, y - reach, cx0, cy0);
+        CellOf(x + reach, y + reach, cx1, cy1);
+
+        for (int cy = cy0; cy <= cy1; cy++) {
+            for (int cx = cx0; cx <= cx1; cx++) {
+                int cell = cy * grid.cols + cx;
+                for (int k = grid.cellStart[cell]; k < grid.cellStart[cell + 1]; k++) {
+                    int i = grid.cellItems[k];
+                    double dx = p->x[i] - x;
+                    double dy = p->y[i] - y;
+                    double minDist = radius + p->radius[i];
+                    if (dx * dx + dy * dy < minDist * minDist)
+                        out.push_back(i);
+                }
+            }
+        }
+    }
+
+    // First ball hit by the ray from (ox, oy) along (dx, dy), up to
+    // maxDistance. The direction does not have to be normalized.
+    RayHit Raycast(double ox, double oy, double dx, double dy,
+                   double maxDistance = 1e30) const
+    {
+        RayHit hit;
+        double length = sqrt(dx * dx + dy * dy);
+        if (size() == 0 || length == 0.0)
+            return hit;
+        dx /= length;
+        dy /= length;
+
+        // Walk the cells along the ray (Amanatides & Woo) over the grid
+        // grown by one cell on every side, so balls bulging out of the
+        // outer cells are found too
+        double cs = grid.cellSize;
+        double minX = grid.originX - cs, maxX = grid.originX + (grid.cols + 1) * cs;
+        double minY = grid.originY - cs, maxY = grid.originY + (grid.rows + 1) * cs;
+
+        double tEnter = 0.0, tExit = maxDistance;
+        if (!ClipSlab(ox, dx, minX, maxX, tEnter, tExit) ||
+            !ClipSlab(oy, dy, minY, maxY, tEnter, tExit))
+            return hit;
+
+        double px = ox + dx * tEnter;
+        double py = oy + dy * tEnter;
+        int cx = Clamp((int)floor((px - grid.originX) / cs), -1, grid.cols);
+        int cy = Clamp((int)floor((py - grid.originY) / cs), -1, grid.rows);
+
+        int stepX = (dx > 0.0) ? 1 : -1;
+        int stepY = (dy > 0.0) ? 1 : -1;
+        double nextX = grid.originX + (cx + (stepX > 0 ? 1 : 0)) * cs;
+        double nextY = grid.originY + (cy + (stepY > 0 ? 1 : 0)) * cs;
+        double tMaxX = (dx != 0.0) ? (nextX - ox) / dx : 1e300;
+        double tMaxY = (dy != 0.0) ? (nextY - oy) / dy : 1e300;
+        double tDeltaX = (dx != 0.0) ? cs / fabs(dx) : 1e300;
+        double tDeltaY = (dy != 0.0) ? cs / fabs(dy) : 1e300;
+
+        hit.distance = maxDistance;
+        for (;;) {
+            for (int ny = cy - 1; ny <= cy + 1; ny++) {
+                for (int nx = cx - 1; nx <= cx + 1; nx++) {
+                    if (nx < 0 || ny < 0 || nx >= grid.cols || ny >= grid.rows)
+                        continue;
+                    int cell = ny * grid.cols + nx;
+                    for (int k = grid.cellStart[cell]; k < grid.cellStart[cell + 1]; k++) {
+                        int i = grid.cellItems[k];
+                        double t;
+                        if (RayCircle(ox, oy, dx, dy, i, t) &&
+                            (t < hit.distance || (t == hit.distance && hit.ball >= 0 && i < hit.ball))) {
+                            hit.ball = i;
+                            hit.distance = t;
+                        }
+                    }
+                }
+            }
+
+            // Every ball crossing the ray before the end of this cell has
+            // been tested
+            double cellExit = (tMaxX < tMaxY) ? tMaxX : tMaxY;
+            if (cellExit >= tExit || (hit.ball >= 0 && hit.distance <= cellExit))
+                break;
+
+            if (tMaxX < tMaxY) {
+                cx += stepX;
+                tMaxX += tDeltaX;
+            } else {
+                cy += stepY;
+                tMaxY += tDeltaY;
+            }
+            if (cx < -1 || cy < -1 || cx > grid.cols || cy > grid.rows)
+                break;
+        }
+
+        if (hit.ball < 0)
+            hit.distance = 0.0;
+        return hit;
+    }
+
+    // The k balls whose centers are closest to (x, y), nearest first
+    void KNearest(double x, double y, int k, std::vector<int>& out) const
+    {
+        out.clear();
+        int n = size();
+        if (n == 0 || k <= 0)
+            return;
+        if (k > n)
+            k = n;
+
+        int cx, cy;
+        CellOf(x, y, cx, cy);
+
+        // Max-heap of the best k so far, worst on top
+        std::vector<std::pair<double, int> > heap;
+        heap.reserve(k + 1);
+
+        int maxRing = std::max(std::max(cx, grid.cols - 1 - cx), std::max(cy, grid.rows - 1 - cy));
+        for (int ring = 0; ring <= maxRing; ring++) {
+            for (int ny = cy - ring; ny <= cy + ring; ny++) {
+                if (ny < 0 || ny >= grid.rows)
+                    continue;
+                // Inner rows of the ring only have their two end cells
+                bool edgeRow = (ny == cy - ring || ny == cy + ring);
+                int stride = edgeRow ? 1 : 2 * ring;
+                for (int nx = cx - ring; nx <= cx + ring; nx += stride) {
+                    if (nx < 0 || nx >= grid.cols)
+                        continue;
+                    int cell = ny * grid.cols + nx;
+                    for (int c = grid.cellStart[cell]; c < grid.cellStart[cell + 1]; c++) {
+                        int i = grid.cellItems[c];
+                        double dx = p->x[i] - x;
+                        double dy = p->y[i] - y;
+                        std::pair<double, int> entry(dx * dx + dy * dy, i);
+                        if ((int)heap.size() < k) {
+                            heap.push_back(entry);
+                            std::push_heap(heap.begin(), heap.end());
+                        } else if (entry < heap.front()) {
+                            std::pop_heap(heap.begin(), heap.end());
+                            heap.back() = entry;
+                            std::push_heap(heap.begin(), heap.end());
+                        }
+                    }
+                }
+            }
+
+            // Balls outside rings 0..ring are at least ring cells away
+            double bound = ring * grid.cellSize;
+            if ((int)heap.size() == k && heap.front().first <= bound * bound)
+                break;
+        }
+
+        std::sort_heap(heap.begin(), heap.end());
+        out.resize(heap.size());
+        for (size_t j = 0; j < heap.size(); j++)
+            out[j] = heap[j].second;
+    }
+
+    // ----------------------------
+    // Batched queries
+    // ----------------------------
+    // count probes split into chunks of batchChunk over the pool
+
+    void PickBatch(const double* x, const double* y, int count, int* out, ThreadPool& pool) const
+    {
+        int chunks = (count + batchChunk - 1) / batchChunk;
+        pool.ParallelFor(chunks, [&](int c) {
+            int end = std::min(count, (c + 1) * batchChunk);
+            for (int q = c * batchChunk; q < end; q++)
+                out[q] = Pick(x[q], y[q]);
+        });
+    }
+
+    // Rays given as origin and direction arrays
+    void RaycastBatch(const double* ox, const double* oy, const double* dx, const double* dy,
+                      int count, double maxDistance, RayHit* out, ThreadPool& pool) const
+    {
+        int chunks = (count + batchChunk - 1) / batchChunk;
+        pool.ParallelFor(chunks, [&](int c) {
+            int end = std::min(count, (c + 1) * batchChunk);
+            for (int q = c * batchChunk; q < end; q++)
+                out[q] = Raycast(ox[q], oy[q], dx[q], dy[q], maxDistance);
+        });
+    }
+
+private:
+    const BasicParticleStore<T>* p = nullptr;
+    SpatialGrid grid;
+
+    static int Clamp(int v, int lo, int hi)
+    {
+        return v < lo ? lo : (v > hi ? hi : v);
+    }
+
+    // Grid cell of a point, clamped to the grid
+    void CellOf(double x, double y, int& cx, int& cy) const
+    {
+        double fx = floor((x - grid.originX) / grid.cellSize);
+        double fy = floor((y - grid.originY) / grid.cellSize);
+        cx = (fx < 0.0) ? 0 : (fx >= grid.cols ? grid.cols - 1 : (int)fx);
+        cy = (fy < 0.0) ? 0 : (fy >= grid.rows ? grid.rows - 1 : (int)fy);
+    }
+
+    // Narrows [t0, t1] to where o + d*t lies in [lo, hi] on one axis
+    static bool ClipSlab(double o, double d, double lo, double hi, double& t0, double& t1)
+    {
+        if (d == 0.0)
+            return o >= lo && o <= hi;
+        double a = (lo - o) / d;
+        double b = (hi - o) / d;
+        if (a > b) std::swap(a, b);
+        if (a > t0) t0 = a;
+        if (b < t1) t1 = b;
+        return t0 <= t1;
+    }
+
+    // Distance along the (normalized) ray to ball i, 0 if the origin is inside
+    bool RayCircle(double ox, double oy, double dx, double dy, int i, double& t) const
+    {
+        double fx = ox - p->x[i];
+        double fy = oy - p->y[i];
+        double r = p->radius[i];
+        double c = fx * fx + fy * fy - r * r;
+        if (c <= 0.0) {
+            t = 0.0;
+            return true;
+        }
+        double b = fx * dx + fy * dy;
+        double disc = b * b - c;
+        if (b > 0.0 || disc < 0.0)
+            return false;
+        t = -b - sqrt(disc);
+        return true;
+    }
+};
+
+typedef BasicSpatialQuery<Scalar> SpatialQuery;
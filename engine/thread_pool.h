@@ -0,0 +1,135 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "trace.h"
+
+// ----------------------------
+// Thread pool
+// ----------------------------
+// A fixed set of worker threads that sleep until ParallelFor hands them a
+// job. The calling thread works on the job too, so a pool of N threads has
+// N-1 workers. Tasks are handed out one index at a time from an atomic
+// counter, which balances uneven tasks (dense vs empty strips) for free.
+class ThreadPool
+{
+public:
+    // threadCount <= 0 -> one thread per hardware core
+    explicit ThreadPool(int threadCount = 0)
+    {
+        if (threadCount <= 0)
+            threadCount = (int)std::thread::hardware_concurrency();
+        if (threadCount <= 0)
+            threadCount = 1;
+
+        for (int i = 1; i < threadCount; i++)
+            workers.emplace_back([this] { WorkerLoop(); });
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            quit = true;
+        }
+        wake.notify_all();
+        for (size_t i = 0; i < workers.size(); i++)
+            workers[i].join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int Size() const { return (int)workers.size() + 1; }
+
+    // Runs task(i) for every i in [0, count) and returns when all are done.
+    // Not reentrant: call it from one thread at a time.
+    void ParallelFor(int count, const std::function<void(int)>& task)
+    {
+        if (count <= 0)
+            return;
+
+        if (workers.empty() || count == 1) {
+            for (int i = 0; i < count; i++)
+                task(i);
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = &task;
+            jobCount = count;
+            nextIndex.store(0);
+            remaining.store(count);
+            generation++;
+        }
+        wake.notify_all();
+
+        RunTasks(task, count);
+
+        // Wait for the workers to finish the indices they grabbed, and for
+        // every worker that picked up this job to let go of it
+        std::unique_lock<std::mutex> lock(mutex);
+        job = nullptr;
+        done.wait(lock, [this] { return remaining.load() == 0 && busyWorkers == 0; });
+    }
+
+private:
+    void RunTasks(const std::function<void(int)>& task, int count)
+    {
+        for (;;) {
+            int i = nextIndex.fetch_add(1);
+            if (i >= count)
+                break;
+            task(i);
+            if (remaining.fetch_sub(1) == 1) {
+                std::lock_guard<std::mutex> lock(mutex);
+                done.notify_all();
+            }
+        }
+    }
+
+    void WorkerLoop()
+    {
+        TraceThreadName("pool worker");
+        unsigned seen = 0;
+        for (;;) {
+            const std::function<void(int)>* task;
+            int count;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return quit || (generation != seen && job); });
+                if (quit)
+                    return;
+                seen = generation;
+                task = job;
+                count = jobCount;
+                busyWorkers++;
+            }
+            RunTasks(*task, count);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                busyWorkers--;
+            }
+            done.notify_all();
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+
+    const std::function<void(int)>* job = nullptr;
+    int jobCount = 0;
+    unsigned generation = 0;
+    int busyWorkers = 0;
+    bool quit = false;
+
+    std::atomic<int> nextIndex{0};
+    std::atomic<int> remaining{0};
+};
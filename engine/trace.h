@@ -0,0 +1,183 @@
+#pragma once
+
+// ----------------------------
+// Scoped tracing
+// ----------------------------
+// Build with -DENGINE_TRACE to record where frame time goes:
+//
+//     void step(double dt)
+//     {
+//         TRACE_SCOPE("step");                // one event from here to }
+//         ...
+//         TRACE_COUNTER("contacts", stat.contacts);
+//     }
+//
+//     TraceWrite("trace.json");               // open in chrome://tracing or
+//                                             // ui.perfetto.dev
+//
+// Every thread appends to its own buffer (thread_local, found once per
+// thread), so recording an event is two clock reads and a vector push - no
+// locks, no atomics. Buffers register themselves once under a mutex and
+// are only read by TraceWrite, which must run while no thread records
+// (e.g. after the loop, or between steps).
+//
+// Without ENGINE_TRACE the macros expand to nothing and TraceWrite /
+// TraceThreadName are empty inline functions, so call sites need no #ifdef.
+//
+// Each thread keeps at most TRACE_MAX_EVENTS events (~32 MB per thread) and
+// drops the rest; trace short runs.
+
+#define TRACE_MAX_EVENTS (1 << 20)
+
+#ifdef ENGINE_TRACE
+
+#include <stdint.h>
+#include <stdio.h>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct TraceEvent
+{
+    const char* name;           // string literal, never copied
+    int64_t begin;              // ns since TraceEpoch()
+    int64_t duration;           // ns, or the value of a counter
+    int counter;                // 1 = counter sample
+};
+
+struct TraceBuffer
+{
+    int tid = 0;
+    std::string threadName;
+    std::vector<TraceEvent> events;
+    long long dropped = 0;
+};
+
+struct TraceRegistry
+{
+    std::mutex mutex;
+    std::vector<std::unique_ptr<TraceBuffer> > buffers;   // owned here, outlive their threads
+};
+
+inline TraceRegistry& GlobalTraceRegistry()
+{
+    static TraceRegistry registry;
+    return registry;
+}
+
+inline std::chrono::steady_clock::time_point TraceEpoch()
+{
+    static const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+    return epoch;
+}
+
+inline int64_t TraceNow()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - TraceEpoch()).count();
+}
+
+// This thread's buffer, registered on first use
+inline TraceBuffer& ThreadTraceBuffer()
+{
+    thread_local TraceBuffer* buffer = nullptr;
+    if (!buffer) {
+        TraceRegistry& registry = GlobalTraceRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.buffers.emplace_back(new TraceBuffer());
+        buffer = registry.buffers.back().get();
+        buffer->tid = (int)registry.buffers.size();
+        buffer->events.reserve(4096);
+    }
+    return *buffer;
+}
+
+inline void TraceRecord(const char* name, int64_t begin, int64_t duration, int counter)
+{
+    TraceBuffer& buffer = ThreadTraceBuffer();
+    if (buffer.events.size() >= TRACE_MAX_EVENTS) {
+        buffer.dropped++;
+        return;
+    }
+    TraceEvent e = { name, begin, duration, counter };
+    buffer.events.push_back(e);
+}
+
+// Name shown for the calling thread's row
+inline void TraceThreadName(const char* name)
+{
+    ThreadTraceBuffer().threadName = name;
+}
+
+struct TraceScope
+{
+    const char* name;
+    int64_t begin;
+
+    explicit TraceScope(const char* n) : name(n), begin(TraceNow()) {}
+    ~TraceScope() { TraceRecord(name, begin, TraceNow() - begin, 0); }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+};
+
+// Writes every thread's events as Chrome trace JSON ("X" complete events,
+// "C" counters, thread names as metadata). Returns false if the file could
+// not be written.
+inline bool TraceWrite(const char* path)
+{
+    FILE* f = fopen(path, "w");
+    if (!f)
+        return false;
+
+    TraceRegistry& registry = GlobalTraceRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+
+    fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    bool first = true;
+    for (size_t b = 0; b < registry.buffers.size(); b++) {
+        const TraceBuffer& buffer = *registry.buffers[b];
+        if (!buffer.threadName.empty()) {
+            fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                    first ? "" : ",\n", buffer.tid, buffer.threadName.c_str());
+            first = false;
+        }
+        if (buffer.dropped > 0)
+            fprintf(stderr, "trace: thread %d dropped %lld events\n", buffer.tid, buffer.dropped);
+
+        for (size_t k = 0; k < buffer.events.size(); k++) {
+            const TraceEvent& e = buffer.events[k];
+            if (e.counter) {
+                fprintf(f, "%s{\"name\":\"%s\",\"ph\":\"C\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"args\":{\"value\":%lld}}",
+                        first ? "" : ",\n", e.name, buffer.tid, e.begin / 1000.0, (long long)e.duration);
+            } else {
+                fprintf(f, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                        first ? "" : ",\n", e.name, buffer.tid, e.begin / 1000.0, e.duration / 1000.0);
+            }
+            first = false;
+        }
+    }
+    fprintf(f, "\n]}\n");
+    return fclose(f) == 0;
+}
+
+#define TRACE_CONCAT2(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT2(a, b)
+
+// Times the rest of the enclosing block; name must be a string literal
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(traceScope, __LINE__)(name)
+
+// Counter sample (shown as a graph track); name must be a string literal
+#define TRACE_COUNTER(name, value) TraceRecord(name, TraceNow(), (int64_t)(value), 1)
+
+#else
+
+inline void TraceThreadName(const char*) {}
+inline bool TraceWrite(const char*) { return false; }
+
+#define TRACE_SCOPE(name) ((void)0)
+#define TRACE_COUNTER(name, value) ((void)0)
+
+#endif
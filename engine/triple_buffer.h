@@ -0,0 +1,49 @@
+#pragma once
+
+#include <atomic>
+
+// ----------------------------
+// Lock-free triple buffer
+// ----------------------------
+// One writer thread, one reader thread, three buffers:
+//
+//   back   - owned by the writer, filled with the next value
+//   middle - the latest published value, waiting for the reader
+//   front  - owned by the reader, stays valid until the next Update()
+//
+// Publish() swaps back and middle, Update() swaps middle and front, both
+// with a single atomic exchange. Neither side ever waits for the other; a
+// slow reader just skips values, a slow writer just gets re-read.
+template <typename T>
+class TripleBuffer
+{
+public:
+    // Writer side
+    T& WriteBuffer() { return buffers[back]; }
+
+    void Publish()
+    {
+        int old = middle.exchange(back | FRESH, std::memory_order_acq_rel);
+        back = old & INDEX_MASK;
+    }
+
+    // Reader side. Returns true if a newer value was picked up.
+    bool Update()
+    {
+        if (!(middle.load(std::memory_order_acquire) & FRESH))
+            return false;
+        int old = middle.exchange(front, std::memory_order_acq_rel);
+        front = old & INDEX_MASK;
+        return true;
+    }
+
+    const T& ReadBuffer() const { return buffers[front]; }
+
+private:
+    enum { INDEX_MASK = 3, FRESH = 4 };
+
+    T buffers[3];
+    int back = 0;
+    std::atomic<int> middle{1};
+    int front = 2;
+};
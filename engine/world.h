@@ -0,0 +1,562 @@
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+#include <algorithm>
+#include <memory>
+#include <vector>
+#include "particle_store.h"
+#include "particle_physics.h"
+#include "spatial_grid.h"
+#include "multilevel_grid.h"
+#include "simd_collide.h"
+#include "thread_pool.h"
+#include "parallel_solver.h"
+#include "jacobi_solver.h"
+#include "spatial_query.h"
+#include "world_config.h"
+#include "policies.h"
+#include "ccd.h"
+#include "morton_order.h"
+#include "trace.h"
+#include "perf_counters.h"
+
+// ----------------------------
+// Headless physics world
+// ----------------------------
+// Everything the SDL demos used to do inside main(): Verlet integration,
+// container constraint and ball-ball collisions. No SDL, no window, no frame
+// delay - step() runs as fast as the CPU allows, so a server can simulate
+// faster than real time and a frontend only has to draw world.particles().
+//
+//     WorldConfig config;
+//     World world(config);
+//     world.addBall(300, 100, 10);
+//     for (int i = 0; i < 600; i++)
+//         world.step(1.0 / 60.0);
+//
+// World is BasicWorld<Scalar>; BasicWorld<float> and BasicWorld<double> can
+// live side by side (see scalar.h). The container, integrator and collision
+// response are compile-time policies (see policies.h):
+//
+//     struct Container { static constexpr double x = 300, y = 300, radius = 250; };
+//     BasicWorld<float, CircleContainer<Container> > world(config);
+
+struct WorldStats
+{
+    long long steps = 0;
+    long long pairsTested = 0;  // candidate pairs, last step
+    long long contacts = 0;     // touching pairs resolved, last step
+    int sleepingBalls = 0;      // after the last step
+    int fastBalls = 0;          // swept by continuous collision, last step
+    int sweptImpacts = 0;       // impacts it resolved, last step
+    int sweptBallImpacts = 0;   // of those, ball-ball (0 with collisions off)
+    int substeps = 0;           // substeps run, last step (adaptive or not)
+    double maxMotion = 0.0;     // adaptive: fastest ball's motion this step, px
+    double residual = 0.0;      // adaptive: largest push in the last substep, px
+};
+
+template <typename T,
+          typename Constraint = ConfigContainer,
+          typename Integrator = VerletIntegrator,
+          typename Response = ElasticResponse>
+class BasicWorld
+{
+public:
+    typedef T Scalar;
+    typedef BasicParticleStore<T> Store;
+
+    explicit BasicWorld(const WorldConfig& config = WorldConfig())
+        : cfg(config), constraint(config), pool(new ThreadPool(config.threads)), solver(*pool), jacobi(*pool)
+    {
+        if (cfg.capacity > 0)
+            store.reserve(cfg.capacity);
+    }
+
+    const WorldConfig& config() const { return cfg; }
+    const WorldStats& stats() const { return stat; }
+
+    Store& particles() { return store; }
+    const Store& particles() const { return store; }
+    int ballCount() const { return store.size(); }
+
+    // Worker threads of the collision solver, free to borrow between steps
+    // (e.g. for rendering)
+    ThreadPool& threadPool() { return *pool; }
+
+    // Point pick / radius / ray cast / k-nearest over the current positions.
+    // Rebuilt on first use after a step or a ball was added or removed; call
+    // invalidateQuery() after moving balls through particles() directly.
+    const BasicSpatialQuery<T>& query()
+    {
+        if (queryDirty || spatialQuery.size() != store.size()) {
+            spatialQuery.Build(store);
+            queryDirty = false;
+        }
+        return spatialQuery;
+    }
+
+    void invalidateQuery() { queryDirty = true; }
+
+    // Adds a ball at rest. The handle stays valid until the ball is removed;
+    // its index (indexOf) changes whenever another ball is removed.
+    ParticleHandle addBall(double x, double y, double radius, uint32_t color = 0xffffffff)
+    {
+        queryDirty = true;
+        return store.Handle(store.Add(x, y, x, y, radius, color));
+    }
+
+    // Adds a ball moving at (vx, vy) px/s, assuming steps of dt seconds
+    ParticleHandle addBall(double x, double y, double vx, double vy, double dt,
+                           double radius, uint32_t color = 0xffffffff)
+    {
+        queryDirty = true;
+        return store.Handle(store.Add(x, y, x - vx * dt, y - vy * dt, radius, color));
+    }
+
+    // Current index of a ball, -1 if it was removed
+    int indexOf(ParticleHandle h) const { return store.IndexOf(h); }
+
+    // Bumped whenever existing balls change index (removal, clear,
+    // reorder), so a consumer holding per-index state from an earlier step
+    // (e.g. SnapshotPublisher's last positions) knows it no longer lines up
+    long long layoutVersion() const { return layout; }
+
+    // O(1): the last ball takes over index i
+    void removeBall(int i)
+    {
+        // Whatever rested on this ball has to fall again (next step)
+        if (SleepEnabled())
+            pendingWakes.push_back(store.island[i]);
+        store.Remove(i);
+        layout++;
+        queryDirty = true;
+    }
+
+    void removeBall(ParticleHandle h)
+    {
+        int i = store.IndexOf(h);
+        if (i >= 0)
+            removeBall(i);
+    }
+
+    void clear()
+    {
+        store.clear();
+        pendingWakes.clear();
+        layout++;
+        queryDirty = true;
+    }
+
+    // Sorts the balls along a Z-order curve (morton_order.h), so balls
+    // that are close in space are close in memory. Handles stay valid.
+    void reorder()
+    {
+        TRACE_SCOPE("reorder");
+        store.Permute(morton.Sort(store, *pool).data());
+        int n = store.size();
+        for (size_t k = 0; k < pendingWakes.size(); k++)
+            if (pendingWakes[k] < n)
+                pendingWakes[k] = store.PermutedIndex(pendingWakes[k]);
+        layout++;
+        queryDirty = true;
+    }
+
+    // Step count and the dt of the last step (the next step's velocity
+    // scale depends on it). restoreState puts both back after the balls
+    // were loaded into particles(), e.g. from a world file, along with the
+    // last step's substep count and residual that adaptive substeps start
+    // from (0 = pick from scratch).
+    double previousDt() const { return lastDt; }
+
+    void restoreState(long long steps, double previousDt, int substeps = 0, double residual = 0.0)
+    {
+        stat = WorldStats();
+        stat.steps = steps;
+        stat.substeps = substeps;
+        stat.residual = residual;
+        lastDt = previousDt;
+        adaptiveSubsteps = cfg.adaptiveSubsteps ? substeps : 0;
+        pendingWakes.clear();
+        queryDirty = true;
+
+        RelabelIslands();
+    }
+
+    // Advances the world by dt seconds: one Verlet step, then
+    // cfg.substeps rounds of collisions and container constraint (or as
+    // many as ChooseSubsteps picks, with cfg.adaptiveSubsteps).
+    // Every cfg.reorderInterval steps the balls are first put in Morton
+    // order: handles stay valid, indices change.
+    void step(double dt)
+    {
+        TRACE_SCOPE("step");
+        if (cfg.reorderInterval > 0 && stat.steps > 0 && stat.steps % cfg.reorderInterval == 0)
+            reorder();
+
+        // Time-corrected Verlet: exact 1.0 for a fixed timestep
+        double velocityScale = (lastDt > 0.0) ? dt / lastDt : 1.0;
+        lastDt = dt;
+
+        bool sleep = SleepEnabled();
+        if (sleep && !pendingWakes.empty())
+            WakeIslands();
+        {
+            TRACE_SCOPE("integrate");
+            PERF_SCOPE(PERF_INTEGRATE);
+            Integrator::Integrate(store, (T)(cfg.gravity * dt * dt), (T)velocityScale,
+                                  sleep ? store.sleeping.data() : nullptr);
+        }
+
+        stat.pairsTested = 0;
+        stat.contacts = 0;
+        if (cfg.ccd && !cfg.bruteForce)
+            SweepFastBalls();
+
+        int substeps = cfg.adaptiveSubsteps ? ChooseSubsteps() : cfg.substeps;
+        for (int s = 0; s < substeps; s++) {
+            TRACE_SCOPE("substep");
+
+            // What the last pass still has to correct tells the next step
+            // whether this many passes were enough
+            bool measure = cfg.adaptiveSubsteps && s == substeps - 1;
+            if (measure) {
+                residualX = store.x;
+                residualY = store.y;
+            }
+            if (cfg.collisions)
+                SolveCollisions();
+            ApplyContainer();
+            if (measure)
+                MeasureResidual();
+        }
+        stat.substeps = substeps;
+
+        if (sleep)
+            UpdateSleep();
+
+        stat.steps++;
+        queryDirty = true;
+
+        TRACE_COUNTER("pairs tested", stat.pairsTested);
+        TRACE_COUNTER("contacts", stat.contacts);
+        TRACE_COUNTER("substeps", substeps);
+    }
+
+private:
+    void SolveCollisions()
+    {
+        TRACE_SCOPE("collisions");
+        if (cfg.bruteForce) {
+            PERF_SCOPE(PERF_NARROW_PHASE);
+            int n = store.size();
+            for (int i = 0; i < n; i++) {
+                for (int j = i + 1; j < n; j++) {
+                    if (Response::Resolve(store, i, j, (T)cfg.elasticity))
+                        stat.contacts++;
+                }
+            }
+            stat.pairsTested += (long long)n * (n - 1) / 2;
+            return;
+        }
+
+        // Re-bin every substep, then only test neighbouring balls
+        if (UseLevels()) {
+            {
+                TRACE_SCOPE("broadphase");
+                PERF_SCOPE(PERF_BROADPHASE);
+                levels.Build(store);
+            }
+            SolveGaussSeidel(levels);
+            return;
+        }
+        {
+            TRACE_SCOPE("broadphase");
+            PERF_SCOPE(PERF_BROADPHASE);
+            grid.Build(store);
+        }
+        if (cfg.solver == SOLVER_JACOBI) {
+            TRACE_SCOPE("narrow phase");
+            PERF_SCOPE(PERF_NARROW_PHASE);
+            bool sleep = SleepEnabled();
+            jacobi.Solve(store, grid, (T)cfg.elasticity, (T)cfg.relaxation,
+                         sleep ? store.sleeping.data() : nullptr, sleep ? store.wake.data() : nullptr);
+            if (jacobi.wakeRequests > 0)
+                WakeIslands();
+            stat.pairsTested += jacobi.pairsTested;
+            stat.contacts += jacobi.contacts;
+            return;
+        }
+        SolveGaussSeidel(grid);
+    }
+
+    template <typename Grid>
+    void SolveGaussSeidel(const Grid& grid)
+    {
+        TRACE_SCOPE("narrow phase");
+        PERF_SCOPE(PERF_NARROW_PHASE);
+        if (SleepEnabled()) {
+            solver.Solve<Response>(store, grid, (T)cfg.elasticity, store.sleeping.data(), store.wake.data());
+            if (solver.wakeRequests > 0)
+                WakeIslands();
+        } else {
+            solver.Solve<Response>(store, grid, (T)cfg.elasticity);
+        }
+        stat.pairsTested += solver.pairsTested;
+        stat.contacts += solver.contacts;
+    }
+
+    bool SleepEnabled() const { return cfg.sleeping && !cfg.bruteForce; }
+
+    // Multi-level grid broadphase (Gauss-Seidel only; Jacobi and the
+    // swept pass scan the uniform grid's cells directly)
+    bool UseLevels() const
+    {
+        return cfg.broadphase == BROADPHASE_MULTILEVEL && cfg.solver == SOLVER_GAUSS_SEIDEL;
+    }
+
+    // ----------------------------
+    // Adaptive substeps
+    // ----------------------------
+    // Enough passes that the fastest ball moves at most cfg.substepMotion
+    // of the smallest radius per pass. The previous step's residual adds
+    // on top: if its last pass still pushed a ball by more than
+    // cfg.substepOverlap smallest radii the solve had not converged and
+    // the count doubles; well below that it decays by one per step.
+    int ChooseSubsteps()
+    {
+        int n = store.size();
+        double maxMotion2 = 0.0, minRadius = 0.0;
+        for (int i = 0; i < n; i++) {
+            double vx = store.x[i] - store.oldx[i];
+            double vy = store.y[i] - store.oldy[i];
+            double motion2 = vx * vx + vy * vy;
+            if (motion2 > maxMotion2)
+                maxMotion2 = motion2;
+            if (i == 0 || store.radius[i] < minRadius)
+                minRadius = store.radius[i];
+        }
+        stat.maxMotion = sqrt(maxMotion2);
+
+        int byMotion = cfg.minSubsteps;
+        if (minRadius > 0.0 && cfg.substepMotion > 0.0)
+            byMotion = (int)ceil(stat.maxMotion / (cfg.substepMotion * minRadius));
+
+        int byResidual = cfg.minSubsteps;
+        if (adaptiveSubsteps > 0) {
+            double tolerance = cfg.substepOverlap * minRadius;
+            if (stat.residual > tolerance)
+                byResidual = adaptiveSubsteps * 2;
+            else if (stat.residual > tolerance * 0.25)
+                byResidual = adaptiveSubsteps;
+            else
+                byResidual = adaptiveSubsteps - 1;
+        } else {
+            byResidual = cfg.maxSubsteps;   // first step: no residual yet
+        }
+
+        int substeps = byMotion > byResidual ? byMotion : byResidual;
+        if (substeps > cfg.maxSubsteps)
+            substeps = cfg.maxSubsteps;
+        if (substeps < cfg.minSubsteps)
+            substeps = cfg.minSubsteps;
+        if (substeps < 1)
+            substeps = 1;
+        adaptiveSubsteps = substeps;
+        return substeps;
+    }
+
+    // Largest correction of the last pass (collisions and container)
+    void MeasureResidual()
+    {
+        int n = store.size();
+        double residual2 = 0.0;
+        for (int i = 0; i < n; i++) {
+            double dx = store.x[i] - residualX[i];
+            double dy = store.y[i] - residualY[i];
+            double d2 = dx * dx + dy * dy;
+            if (d2 > residual2)
+                residual2 = d2;
+        }
+        stat.residual = sqrt(residual2);
+    }
+
+    // Continuous collision for the balls the Verlet step moved far (ccd.h)
+    void SweepFastBalls()
+    {
+        TRACE_SCOPE("ccd");
+        bool sleep = SleepEnabled();
+        swept.Run(store, grid, constraint, (T)cfg.elasticity, cfg.ccdThreshold, cfg.collisions,
+                  sleep ? store.wake.data() : nullptr);
+        stat.fastBalls = swept.fastBalls;
+        stat.sweptImpacts = swept.impacts;
+        stat.sweptBallImpacts = swept.ballImpacts;
+        if (sleep && swept.impacts > 0)
+            WakeIslands();
+    }
+
+    // Wakes every island that has a ball with a wake request, or that lost
+    // a ball since the last step
+    void WakeIslands()
+    {
+        int n = store.size();
+        islandAwake.assign(IslandLabels(), 0);
+        for (size_t k = 0; k < pendingWakes.size(); k++)
+            islandAwake[pendingWakes[k]] = 1;
+        pendingWakes.clear();
+
+        for (int i = 0; i < n; i++) {
+            if (store.wake[i]) {
+                islandAwake[store.island[i]] = 1;
+                store.wake[i] = 0;
+            }
+        }
+
+        for (int i = 0; i < n; i++) {
+            if (store.sleeping[i] && islandAwake[store.island[i]]) {
+                store.sleeping[i] = 0;
+                store.restSteps[i] = 0;
+                store.anchorX[i] = store.x[i];
+                store.anchorY[i] = store.y[i];
+            }
+        }
+    }
+
+    // Loaded island ids come from the saved world's last sleep update and
+    // can name balls removed before it was saved - or anything at all, in a
+    // corrupt file. Ids are only compared, so ids >= the ball count are
+    // renumbered to n, n + 1, ... and the tables stay within 2n entries.
+    void RelabelIslands()
+    {
+        int n = store.size();
+        std::vector<int> high;  // distinct ids >= n, sorted
+        for (int i = 0; i < n; i++)
+            if (store.island[i] >= n)
+                high.push_back(store.island[i]);
+        std::sort(high.begin(), high.end());
+        high.erase(std::unique(high.begin(), high.end()), high.end());
+        for (int i = 0; i < n; i++)
+            if (store.island[i] >= n)
+                store.island[i] = n + (int)(std::lower_bound(high.begin(), high.end(), store.island[i]) - high.begin());
+        islandLabels = n + (int)high.size();
+    }
+
+    // Island ids are ball indices from the last UpdateSleep. Balls removed
+    // since then leave ids up to the old ball count behind.
+    int IslandLabels()
+    {
+        if (islandLabels < store.size())
+            islandLabels = store.size();
+        return islandLabels;
+    }
+
+    int FindIsland(int i)
+    {
+        std::vector<int>& parent = store.island;
+        while (parent[i] != i) {
+            parent[i] = parent[parent[i]];
+            i = parent[i];
+        }
+        return i;
+    }
+
+    // End of step: track how long each ball has rested, group touching balls
+    // into islands and put islands to sleep whose balls have all rested for
+    // cfg.sleepSteps steps
+    void UpdateSleep()
+    {
+        TRACE_SCOPE("sleep");
+        int n = store.size();
+        double limit2 = cfg.sleepDistance * cfg.sleepDistance;
+
+        for (int i = 0; i < n; i++) {
+            if (store.sleeping[i])
+                continue;
+            double dx = store.x[i] - store.anchorX[i];
+            double dy = store.y[i] - store.anchorY[i];
+            if (dx * dx + dy * dy > limit2) {
+                store.anchorX[i] = store.x[i];
+                store.anchorY[i] = store.y[i];
+                store.restSteps[i] = 0;
+            } else {
+                store.restSteps[i]++;
+            }
+        }
+
+        // Islands: union-find over touching pairs (within sleepDistance)
+        for (int i = 0; i < n; i++)
+            store.island[i] = i;
+        islandLabels = n;
+
+        auto link = [&](int a, int b) {
+            double dx = store.x[b] - store.x[a];
+            double dy = store.y[b] - store.y[a];
+            double reach = store.radius[a] + store.radius[b] + cfg.sleepDistance;
+            if (dx * dx + dy * dy < reach * reach) {
+                int ra = FindIsland(a), rb = FindIsland(b);
+                if (ra != rb)
+                    store.island[ra > rb ? ra : rb] = ra < rb ? ra : rb;
+            }
+        };
+        if (UseLevels()) {
+            if (!cfg.collisions)
+                levels.Build(store);
+            levels.ForEachPair(link);
+        } else {
+            if (!cfg.collisions)
+                grid.Build(store);
+            grid.ForEachPair(link);
+        }
+
+        // An island sleeps only if every ball in it is resting
+        islandAwake.assign(n, 0);
+        for (int i = 0; i < n; i++) {
+            store.island[i] = FindIsland(i);
+            if (!store.sleeping[i] && store.restSteps[i] < cfg.sleepSteps)
+                islandAwake[store.island[i]] = 1;
+        }
+
+        stat.sleepingBalls = 0;
+        for (int i = 0; i < n; i++) {
+            if (!islandAwake[store.island[i]] && !store.sleeping[i]) {
+                store.sleeping[i] = 1;
+                store.oldx[i] = store.x[i];
+                store.oldy[i] = store.y[i];
+            }
+            stat.sleepingBalls += store.sleeping[i];
+        }
+    }
+
+    void ApplyContainer()
+    {
+        TRACE_SCOPE("container");
+        PERF_SCOPE(PERF_CONSTRAINT);
+        constraint.Apply(store, (T)cfg.elasticity);
+    }
+
+    WorldConfig cfg;
+    Constraint constraint;
+    WorldStats stat;
+    Store store;
+
+    SpatialGrid grid;
+    MultiLevelGrid levels;
+    std::unique_ptr<ThreadPool> pool;
+    ParallelSolver solver;
+    BasicJacobiSolver<T> jacobi;
+    SweptCollisions swept;
+    MortonOrder morton;
+
+    BasicSpatialQuery<T> spatialQuery;
+    bool queryDirty = true;
+    long long layout = 0;
+
+    double lastDt = 0.0;
+    int adaptiveSubsteps = 0;           // count of the last adaptive step, 0 = none yet
+    AlignedArray<T> residualX, residualY;   // positions before the last substep
+    std::vector<uint8_t> islandAwake;   // per island root, sleep scratch
+    std::vector<int> pendingWakes;      // islands of removed balls
+    int islandLabels = 0;
+};
+
+typedef BasicWorld<Scalar> World;
@@ -0,0 +1,98 @@
+#pragma once
+
+// ----------------------------
+// World configuration
+// ----------------------------
+// Runtime settings of a World. Everything is double whatever the engine's
+// scalar type; the world converts on use.
+
+enum ContainerShape
+{
+    CONTAINER_NONE,     // open world
+    CONTAINER_CIRCLE,   // balls stay inside a circle
+    CONTAINER_BOX       // balls stay inside [0, width] x [0, height]
+};
+
+enum SolverMode
+{
+    SOLVER_GAUSS_SEIDEL,    // pairs resolved one after another (parallel_solver.h)
+    SOLVER_JACOBI           // corrections summed, then applied (jacobi_solver.h)
+};
+
+enum BroadphaseMode
+{
+    BROADPHASE_GRID,        // one uniform grid, cells fit the largest ball (spatial_grid.h)
+    BROADPHASE_MULTILEVEL   // a level per size class (multilevel_grid.h)
+};
+
+struct WorldConfig
+{
+    double gravity = 1800.0;    // px/s^2 downward (0.5 px per frame at 60 Hz)
+    double elasticity = 0.9;    // 1.0 = perfectly elastic
+    int substeps = 8;           // constraint + collision passes per step
+
+    // Read by ConfigContainer, the default constraint policy (policies.h);
+    // a world with a compile-time container ignores them
+    ContainerShape container = CONTAINER_CIRCLE;
+    double containerX = 300.0, containerY = 300.0;   // circle center
+    double containerRadius = 250.0;
+    double boxWidth = 600.0, boxHeight = 600.0;
+
+    bool collisions = true;     // ball-ball collisions on/off
+    bool bruteForce = false;    // test every pair (reference path)
+
+    // Grid path collision solver. Jacobi gives the same result for every
+    // thread count (not across reorders, which change the summation order)
+    // but converges slower; relaxation scales its averaged position
+    // corrections (1 = plain average, unstable from about 1.9).
+    // Jacobi always uses the elastic response, whatever the Response policy.
+    SolverMode solver = SOLVER_GAUSS_SEIDEL;
+    double relaxation = 1.5;
+
+    // Grid path broadphase. Multi-level pays off with mixed radii (each
+    // ball only meets candidates its own size or bigger); Gauss-Seidel
+    // only, Jacobi always bins into the uniform grid.
+    BroadphaseMode broadphase = BROADPHASE_GRID;
+
+    // Steps between Morton reorders of the particle arrays, 0 = never.
+    // Keeps neighbours close in memory on long runs; ball indices change
+    // on every reorder (handles do not). Anything that keeps per-index
+    // state across steps, such as an interpolating frontend's previous
+    // positions, has to drop it when BasicWorld::layoutVersion() changes;
+    // SnapshotPublisher does.
+    int reorderInterval = 0;
+
+    // Collision threads, 0 = one per core. The strip layout depends on the
+    // thread count, so keep it fixed when runs must match bit for bit.
+    int threads = 1;
+
+    // Balls to make room for up front, so spawning never reallocates
+    int capacity = 0;
+
+    // Sleeping: a group of touching balls that has stayed within
+    // sleepDistance px of where it came to rest for sleepSteps steps is
+    // frozen - no integration, no collisions among its members - until an
+    // awake ball touches it or one of its balls is removed. Grid path only.
+    bool sleeping = false;
+    double sleepDistance = 1.0;
+    int sleepSteps = 30;
+
+    // Continuous collision: balls moving more than ccdThreshold radii per
+    // step are swept against the balls they pass and against a circular
+    // container, so small fast balls cannot tunnel even with 1-2 substeps
+    // (see ccd.h). With collisions off only the container is swept. Grid
+    // path only.
+    bool ccd = false;
+    double ccdThreshold = 1.0;
+
+    // Adaptive substeps: every step picks its own count in [minSubsteps,
+    // maxSubsteps] instead of using substeps. Enough passes that no ball
+    // moves more than substepMotion smallest radii per pass, and more than
+    // the step before if its last pass still had to push a ball further
+    // than substepOverlap smallest radii (overlap the solve left behind).
+    // Calm or sleeping scenes drop to minSubsteps. See WorldStats::substeps.
+    bool adaptiveSubsteps = false;
+    int minSubsteps = 1, maxSubsteps = 8;
+    double substepMotion = 0.25;
+    double substepOverlap = 0.02;
+};
@@ -0,0 +1,449 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include "particle_store.h"
+#include "world_config.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// ----------------------------
+// World files
+// ----------------------------
+// Binary snapshot of a world: a fixed header, then the particle arrays
+// exactly as they sit in memory, each starting on a 64 byte boundary.
+//
+//     +----------------------+  0
+//     | WorldFileHeader      |
+//     +----------------------+  array[0].offset
+//     | x[ballCount]         |
+//     +----------------------+  array[1].offset
+//     | y[ballCount]         |
+//     | ...                  |
+//
+// SaveWorld writes it in one sequential pass. WorldFile maps it read-only
+// and hands out pointers straight into the mapping - no parsing, the only
+// work on load is checking the header and the island ids (they index the
+// sleep tables). LoadInto then copies the arrays into a world with one
+// memcpy each, ready to step.
+//
+//     SaveWorld(world, "settled_1m.world");
+//
+//     WorldFile file;
+//     if (file.Open("settled_1m.world")) {
+//         World world(file.Config());
+//         file.LoadInto(world);
+//     }
+//
+// Little-endian only (the header records the byte order and a mismatch is
+// rejected). Handles are not stored; loading gives fresh ones.
+
+#define WORLD_FILE_VERSION 6
+#define WORLD_FILE_ALIGN 64
+
+enum WorldFileArray
+{
+    WORLD_ARRAY_X,
+    WORLD_ARRAY_Y,
+    WORLD_ARRAY_OLDX,
+    WORLD_ARRAY_OLDY,
+    WORLD_ARRAY_RADIUS,
+    WORLD_ARRAY_ANCHORX,
+    WORLD_ARRAY_ANCHORY,
+    WORLD_ARRAY_COLOR,          // uint32
+    WORLD_ARRAY_REST_STEPS,     // int32
+    WORLD_ARRAY_ISLAND,         // int32
+    WORLD_ARRAY_SLEEPING,       // uint8
+    WORLD_ARRAY_COUNT
+};
+
+struct WorldFileArrayInfo
+{
+    uint64_t offset;            // from the start of the file
+    uint64_t bytes;
+};
+
+// WorldConfig with fixed-size fields, as stored in a file (also used by
+// input recordings, see input_replay.h)
+struct WorldFileConfig
+{
+    double gravity, elasticity;
+    int32_t substeps;
+    int32_t container;
+    double containerX, containerY, containerRadius;
+    double boxWidth, boxHeight;
+    int32_t collisions, bruteForce;
+    int32_t threads, capacity;
+    int32_t sleeping, sleepSteps;
+    double sleepDistance;
+    int32_t ccd, reserved;
+    double ccdThreshold;
+    int32_t adaptiveSubsteps;
+    int32_t minSubsteps, maxSubsteps;
+    int32_t solver;
+    double substepMotion, substepOverlap;
+    double relaxation;
+    int32_t broadphase, reorderInterval;
+
+    static WorldFileConfig From(const WorldConfig& cfg)
+    {
+        WorldFileConfig c;
+        memset(&c, 0, sizeof(c));
+        c.gravity = cfg.gravity;
+        c.elasticity = cfg.elasticity;
+        c.substeps = cfg.substeps;
+        c.container = cfg.container;
+        c.containerX = cfg.containerX;
+        c.containerY = cfg.containerY;
+        c.containerRadius = cfg.containerRadius;
+        c.boxWidth = cfg.boxWidth;
+        c.boxHeight = cfg.boxHeight;
+        c.collisions = cfg.collisions;
+        c.bruteForce = cfg.bruteForce;
+        c.threads = cfg.threads;
+        c.capacity = cfg.capacity;
+        c.sleeping = cfg.sleeping;
+        c.sleepSteps = cfg.sleepSteps;
+        c.sleepDistance = cfg.sleepDistance;
+        c.ccd = cfg.ccd;
+        c.ccdThreshold = cfg.ccdThreshold;
+        c.adaptiveSubsteps = cfg.adaptiveSubsteps;
+        c.minSubsteps = cfg.minSubsteps;
+        c.maxSubsteps = cfg.maxSubsteps;
+        c.substepMotion = cfg.substepMotion;
+        c.substepOverlap = cfg.substepOverlap;
+        c.solver = cfg.solver;
+        c.relaxation = cfg.relaxation;
+        c.broadphase = cfg.broadphase;
+        c.reorderInterval = cfg.reorderInterval;
+        return c;
+    }
+
+    WorldConfig ToConfig() const
+    {
+        WorldConfig cfg;
+        cfg.gravity = gravity;
+        cfg.elasticity = elasticity;
+        cfg.substeps = substeps;
+        cfg.container = (ContainerShape)container;
+        cfg.containerX = containerX;
+        cfg.containerY = containerY;
+        cfg.containerRadius = containerRadius;
+        cfg.boxWidth = boxWidth;
+        cfg.boxHeight = boxHeight;
+        cfg.collisions = collisions != 0;
+        cfg.bruteForce = bruteForce != 0;
+        cfg.threads = threads;
+        cfg.capacity = capacity;
+        cfg.sleeping = sleeping != 0;
+        cfg.sleepSteps = sleepSteps;
+        cfg.sleepDistance = sleepDistance;
+        cfg.ccd = ccd != 0;
+        cfg.ccdThreshold = ccdThreshold;
+        cfg.adaptiveSubsteps = adaptiveSubsteps != 0;
+        cfg.minSubsteps = minSubsteps;
+        cfg.maxSubsteps = maxSubsteps;
+        cfg.substepMotion = substepMotion;
+        cfg.substepOverlap = substepOverlap;
+        cfg.solver = (SolverMode)solver;
+        cfg.relaxation = relaxation;
+        cfg.broadphase = (BroadphaseMode)broadphase;
+        cfg.reorderInterval = reorderInterval;
+        return cfg;
+    }
+};
+
+struct WorldFileHeader
+{
+    char magic[8];              // "NWORLD\0\0"
+    uint32_t version;
+    uint32_t byteOrder;         // 0x01020304 as written
+    uint32_t headerBytes;       // sizeof(WorldFileHeader)
+    uint32_t scalarBytes;       // 4 = float, 8 = double positions / radii
+
+    int64_t ballCount;
+    int64_t steps;
+    double previousDt;
+    int32_t substeps;           // last step's count and residual (adaptive substeps)
+    int32_t reserved;
+    double residual;
+
+    WorldFileConfig config;
+
+    WorldFileArrayInfo arrays[WORLD_ARRAY_COUNT];
+};
+
+static const char WORLD_FILE_MAGIC[8] = { 'N', 'W', 'O', 'R', 'L', 'D', 0, 0 };
+
+inline uint64_t WorldFileAlign(uint64_t n)
+{
+    return (n + WORLD_FILE_ALIGN - 1) / WORLD_FILE_ALIGN * WORLD_FILE_ALIGN;
+}
+
+// ----------------------------
+// Save
+// ----------------------------
+// Works for any BasicWorld; returns false if the file could not be written
+template <typename WorldType>
+bool SaveWorld(const WorldType& world, const char* path)
+{
+    typedef typename WorldType::Scalar T;
+    const BasicParticleStore<T>& p = world.particles();
+    uint64_t n = (uint64_t)p.size();
+
+    WorldFileHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, WORLD_FILE_MAGIC, sizeof(h.magic));
+    h.version = WORLD_FILE_VERSION;
+    h.byteOrder = 0x01020304;
+    h.headerBytes = sizeof(WorldFileHeader);
+    h.scalarBytes = sizeof(T);
+    h.ballCount = (int64_t)n;
+    h.steps = world.stats().steps;
+    h.previousDt = world.previousDt();
+    h.substeps = world.stats().substeps;
+    h.residual = world.stats().residual;
+
+    h.config = WorldFileConfig::From(world.config());
+
+    // Array table, in file order
+    const void* data[WORLD_ARRAY_COUNT] = {
+        p.x.data(), p.y.data(), p.oldx.data(), p.oldy.data(), p.radius.data(),
+        p.anchorX.data(), p.anchorY.data(),
+        p.color.data(), p.restSteps.data(), p.island.data(), p.sleeping.data()
+    };
+    const uint64_t elementBytes[WORLD_ARRAY_COUNT] = {
+        sizeof(T), sizeof(T), sizeof(T), sizeof(T), sizeof(T),
+        sizeof(T), sizeof(T),
+        4, 4, 4, 1
+    };
+    static_assert(sizeof(int) == 4, "world files store int as 32 bit");
+
+    uint64_t offset = WorldFileAlign(sizeof(WorldFileHeader));
+    for (int a = 0; a < WORLD_ARRAY_COUNT; a++) {
+        h.arrays[a].offset = offset;
+        h.arrays[a].bytes = n * elementBytes[a];
+        offset = WorldFileAlign(offset + h.arrays[a].bytes);
+    }
+
+    FILE* f = fopen(path, "wb");
+    if (!f)
+        return false;
+
+    static const char zeros[WORLD_FILE_ALIGN] = { 0 };
+    bool ok = fwrite(&h, sizeof(h), 1, f) == 1;
+    uint64_t written = sizeof(h);
+    for (int a = 0; a < WORLD_ARRAY_COUNT && ok; a++) {
+        ok = fwrite(zeros, 1, h.arrays[a].offset - written, f) == h.arrays[a].offset - written;
+        if (ok && h.arrays[a].bytes > 0)
+            ok = fwrite(data[a], 1, h.arrays[a].bytes, f) == h.arrays[a].bytes;
+        written = h.arrays[a].offset + h.arrays[a].bytes;
+    }
+
+    if (fclose(f) != 0)
+        ok = false;
+    return ok;
+}
+
+// ----------------------------
+// Load (memory mapped)
+// ----------------------------
+class WorldFile
+{
+public:
+    WorldFile() {}
+    ~WorldFile() { Close(); }
+
+    WorldFile(const WorldFile&) = delete;
+    WorldFile& operator=(const WorldFile&) = delete;
+
+    // Maps the file and checks the header. Returns false (and stays
+    // closed) if the file is missing, truncated or not a world file.
+    bool Open(const char* path)
+    {
+        Close();
+        if (!Map(path))
+            return false;
+        if (!Valid()) {
+            Close();
+            return false;
+        }
+        return true;
+    }
+
+    void Close()
+    {
+        Unmap();
+        base = nullptr;
+        length = 0;
+    }
+
+    bool IsOpen() const { return base != nullptr; }
+
+    const WorldFileHeader& Header() const { return *(const WorldFileHeader*)base; }
+    int BallCount() const { return (int)Header().ballCount; }
+    bool IsFloat() const { return Header().scalarBytes == sizeof(float); }
+
+    // The configuration the world was saved with
+    WorldConfig Config() const { return Header().config.ToConfig(); }
+
+    // Raw array inside the mapping, e.g. (const float*)Array(WORLD_ARRAY_X)
+    const void* Array(int a) const { return base + Header().arrays[a].offset; }
+
+    // Copies the balls and step state into world, replacing its balls.
+    // Same scalar type: one memcpy per array. Otherwise converted per value.
+    template <typename WorldType>
+    void LoadInto(WorldType& world) const
+    {
+        typedef typename WorldType::Scalar T;
+        BasicParticleStore<T>& p = world.particles();
+        int n = BallCount();
+
+        p.Resize(n);
+        CopyScalars(WORLD_ARRAY_X, p.x.data(), n);
+        CopyScalars(WORLD_ARRAY_Y, p.y.data(), n);
+        CopyScalars(WORLD_ARRAY_OLDX, p.oldx.data(), n);
+        CopyScalars(WORLD_ARRAY_OLDY, p.oldy.data(), n);
+        CopyScalars(WORLD_ARRAY_RADIUS, p.radius.data(), n);
+        CopyScalars(WORLD_ARRAY_ANCHORX, p.anchorX.data(), n);
+        CopyScalars(WORLD_ARRAY_ANCHORY, p.anchorY.data(), n);
+        CopyBytes(WORLD_ARRAY_COLOR, p.color.data());
+        CopyBytes(WORLD_ARRAY_REST_STEPS, p.restSteps.data());
+        CopyBytes(WORLD_ARRAY_ISLAND, p.island.data());
+        CopyBytes(WORLD_ARRAY_SLEEPING, p.sleeping.data());
+
+        world.restoreState(Header().steps, Header().previousDt, Header().substeps, Header().residual);
+    }
+
+private:
+    const char* base = nullptr;
+    uint64_t length = 0;
+#ifdef _WIN32
+    HANDLE fileHandle = INVALID_HANDLE_VALUE;
+    HANDLE mapping = NULL;
+#endif
+
+    bool Valid() const
+    {
+        if (length < sizeof(WorldFileHeader))
+            return false;
+        const WorldFileHeader& h = Header();
+        if (memcmp(h.magic, WORLD_FILE_MAGIC, sizeof(h.magic)) != 0 ||
+            h.version != WORLD_FILE_VERSION || h.byteOrder != 0x01020304 ||
+            h.headerBytes != sizeof(WorldFileHeader) ||
+            (h.scalarBytes != sizeof(float) && h.scalarBytes != sizeof(double)) ||
+            h.ballCount < 0 || h.ballCount > 0x7fffffff)
+            return false;
+
+        // Every array must fit in the file and hold ballCount elements
+        const uint64_t elementBytes[WORLD_ARRAY_COUNT] = {
+            h.scalarBytes, h.scalarBytes, h.scalarBytes, h.scalarBytes, h.scalarBytes,
+            h.scalarBytes, h.scalarBytes, 4, 4, 4, 1
+        };
+        for (int a = 0; a < WORLD_ARRAY_COUNT; a++) {
+            const WorldFileArrayInfo& info = h.arrays[a];
+            if (info.bytes != (uint64_t)h.ballCount * elementBytes[a] ||
+                info.offset % WORLD_FILE_ALIGN != 0 ||
+                info.offset > length || info.bytes > length - info.offset)
+                return false;
+        }
+
+        // Island ids index the sleep tables
+        const int32_t* island = (const int32_t*)(base + h.arrays[WORLD_ARRAY_ISLAND].offset);
+        for (int64_t i = 0; i < h.ballCount; i++)
+            if (island[i] < 0)
+                return false;
+        return true;
+    }
+
+    template <typename T>
+    void CopyScalars(int a, T* out, int n) const
+    {
+        if (Header().scalarBytes == sizeof(T)) {
+            memcpy(out, Array(a), (size_t)n * sizeof(T));
+        } else if (IsFloat()) {
+            const float* in = (const float*)Array(a);
+            for (int i = 0; i < n; i++)
+                out[i] = (T)in[i];
+        } else {
+            const double* in = (const double*)Array(a);
+            for (int i = 0; i < n; i++)
+                out[i] = (T)in[i];
+        }
+    }
+
+    void CopyBytes(int a, void* out) const
+    {
+        memcpy(out, Array(a), (size_t)Header().arrays[a].bytes);
+    }
+
+#ifdef _WIN32
+    bool Map(const char* path)
+    {
+        fileHandle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                                 FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+        if (fileHandle == INVALID_HANDLE_VALUE)
+            return false;
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(fileHandle, &size) || size.QuadPart == 0) {
+            Unmap();
+            return false;
+        }
+        mapping = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (!mapping) {
+            Unmap();
+            return false;
+        }
+        base = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        length = (uint64_t)size.QuadPart;
+        if (!base) {
+            Unmap();
+            return false;
+        }
+        return true;
+    }
+
+    void Unmap()
+    {
+        if (base) UnmapViewOfFile(base);
+        if (mapping) CloseHandle(mapping);
+        if (fileHandle != INVALID_HANDLE_VALUE) CloseHandle(fileHandle);
+        mapping = NULL;
+        fileHandle = INVALID_HANDLE_VALUE;
+    }
+#else
+    bool Map(const char* path)
+    {
+        int fd = open(path, O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0) {
+            close(fd);
+            return false;
+        }
+        void* m = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);     // the mapping keeps the file alive
+        if (m == MAP_FAILED)
+            return false;
+        base = (const char*)m;
+        length = (uint64_t)st.st_size;
+        return true;
+    }
+
+    void Unmap()
+    {
+        if (base)
+            munmap((void*)base, (size_t)length);
+    }
+#endif
+};
@@ -0,0 +1,438 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "span_raster.h"
+#include "engine/particle_store.h"
+#include "engine/perf_counters.h"
+#include "engine/thread_pool.h"
+#include "engine/trace.h"
+#include "engine/world_config.h"
+
+// ----------------------------
+// Headless frame capture
+// ----------------------------
+// Renders balls into an off-screen 0x00RRGGBB buffer (same span rasterizer
+// as the SDL demos, no SDL needed) and hands finished frames to a writer
+// thread through a bounded queue. The writer converts and writes them, so
+// the simulation never waits on the disk - only when every buffer in the
+// queue is still waiting to be written (the disk is slower than the
+// simulation) does Acquire() block, and that time is reported.
+//
+//     FrameWriter writer;
+//     writer.Open("run.y4m", 1920, 1080, 60);      // or "frames/f_%06d.ppm"
+//     CaptureView view = FitView(world.config(), 1920, 1080);
+//     for (...) {
+//         world.step(dt);
+//         CaptureFrame* frame = writer.Acquire();
+//         RenderFrame(*frame, world.particles(), view, &world.threadPool());
+//         writer.Submit(frame);
+//     }
+//     writer.Close();
+//
+// .y4m paths get one YUV4MPEG2 stream (4:2:0, BT.601, ffmpeg and most
+// players read it directly); anything else is a printf pattern for a
+// numbered sequence of binary PPM files (see FramePathPattern).
+
+#define CAPTURE_QUEUE_FRAMES 8      // frames in flight between renderer and writer
+#define CAPTURE_MAX_SIZE 16384      // largest frame width / height accepted
+#define CAPTURE_BACKGROUND 0x000000
+#define CAPTURE_CONTAINER_COLOR 0xCCCCCC
+
+struct CaptureFrame
+{
+    int width = 0, height = 0;
+    std::vector<uint32_t> pixels;   // 0x00RRGGBB, row-major
+    long long index = 0;            // set by Submit
+};
+
+// ----------------------------
+// Off-screen span target
+// ----------------------------
+struct FrameTarget
+{
+    uint32_t* pixels;
+    int width;
+    int clipX0, clipY0, clipX1, clipY1;
+};
+
+inline void FillSpan(const FrameTarget& t, int y, int x0, int x1, uint32_t color)
+{
+    if (y < t.clipY0 || y >= t.clipY1)
+        return;
+    if (x0 < t.clipX0) x0 = t.clipX0;
+    if (x1 >= t.clipX1) x1 = t.clipX1 - 1;
+    if (x0 > x1)
+        return;
+
+    uint32_t* row = t.pixels + (size_t)y * t.width;
+    for (int x = x0; x <= x1; x++)
+        row[x] = color;
+}
+
+// ----------------------------
+// World to pixel mapping
+// ----------------------------
+struct CaptureView
+{
+    double originX = 0.0, originY = 0.0;    // world point at pixel (0, 0)
+    double scale = 1.0;                     // pixels per world unit
+};
+
+// View that fits the world's container into a width x height frame,
+// centered. Open worlds fall back to the 600x600 demo window.
+inline CaptureView FitView(const WorldConfig& cfg, int width, int height)
+{
+    double minX = 0.0, minY = 0.0, maxX = 600.0, maxY = 600.0;
+    if (cfg.container == CONTAINER_CIRCLE) {
+        minX = cfg.containerX - cfg.containerRadius;
+        maxX = cfg.containerX + cfg.containerRadius;
+        minY = cfg.containerY - cfg.containerRadius;
+        maxY = cfg.containerY + cfg.containerRadius;
+    } else if (cfg.container == CONTAINER_BOX) {
+        maxX = cfg.boxWidth;
+        maxY = cfg.boxHeight;
+    }
+
+    // 2% margin so the container outline is fully visible
+    double sx = width / ((maxX - minX) * 1.04);
+    double sy = height / ((maxY - minY) * 1.04);
+    CaptureView view;
+    view.scale = sx < sy ? sx : sy;
+    view.originX = 0.5 * (minX + maxX) - 0.5 * width / view.scale;
+    view.originY = 0.5 * (minY + maxY) - 0.5 * height / view.scale;
+    return view;
+}
+
+// ----------------------------
+// Rendering
+// ----------------------------
+// The frame is cut into horizontal bands drawn concurrently on pool (if
+// given); every band draws its balls in index order, so the last ball to
+// cover a pixel wins exactly as in the serial renderer.
+template <typename T>
+void RenderFrame(CaptureFrame& frame, const BasicParticleStore<T>& balls, const CaptureView& view,
+                 ThreadPool* pool = nullptr, const WorldConfig* container = nullptr)
+{
+    TRACE_SCOPE("render frame");
+    PERF_SCOPE(PERF_RENDER);
+    int n = balls.size();
+    double scale = view.scale;
+    std::fill(frame.pixels.begin(), frame.pixels.end(), (uint32_t)CAPTURE_BACKGROUND);
+
+    // Span tables must exist before the threads read them
+    SpanTables& tables = GlobalSpanTables();
+    double maxRadius = 0.0;
+    for (int i = 0; i < n; i++)
+        if (balls.radius[i] > maxRadius)
+            maxRadius = balls.radius[i];
+    tables.Reserve((int)(maxRadius * scale));
+
+    int bands = pool ? pool->Size() * 4 : 1;
+    int bandHeight = (frame.height + bands - 1) / bands;
+
+    auto drawBand = [&](int band) {
+        TRACE_SCOPE("render band");
+        FrameTarget t;
+        t.pixels = frame.pixels.data();
+        t.width = frame.width;
+        t.clipX0 = 0;
+        t.clipX1 = frame.width;
+        t.clipY0 = band * bandHeight;
+        t.clipY1 = t.clipY0 + bandHeight < frame.height ? t.clipY0 + bandHeight : frame.height;
+
+        for (int i = 0; i < n; i++) {
+            double cy = (balls.y[i] - view.originY) * scale;
+            double r = balls.radius[i] * scale;
+            if (cy + r < t.clipY0 - 1 || cy - r > t.clipY1 + 1)
+                continue;
+            double cx = (balls.x[i] - view.originX) * scale;
+            FillCircleSpans(t, tables, cx, cy, r, balls.color[i] & 0xffffff);
+        }
+
+        if (container && container->container == CONTAINER_CIRCLE)
+            DrawRingSpans(t, (container->containerX - view.originX) * scale,
+                          (container->containerY - view.originY) * scale,
+                          container->containerRadius * scale, CAPTURE_CONTAINER_COLOR);
+    };
+
+    if (pool)
+        pool->ParallelFor(bands, drawBand);
+    else
+        drawBand(0);
+}
+
+// ----------------------------
+// PPM path patterns
+// ----------------------------
+// The path goes to snprintf with the frame number, so it may hold exactly
+// one integer conversion (%d, %i, optionally with 0 / - flags and a width,
+// e.g. %06d) and "%%" for a literal percent sign. A path with no
+// conversion gets "_%06d" before its extension ("out.ppm" ->
+// "out_000000.ppm", ...) instead of overwriting one file every frame.
+// Returns false for anything else (%s, %n, a stray %, two numbers).
+inline bool FramePathPattern(const char* path, std::string& pattern)
+{
+    int conversions = 0;
+    for (const char* c = path; *c; c++) {
+        if (*c != '%')
+            continue;
+        c++;
+        if (*c == '%')
+            continue;
+        while (*c == '0' || *c == '-')
+            c++;
+        while (*c >= '0' && *c <= '9')
+            c++;
+        if (*c != 'd' && *c != 'i')
+            return false;
+        conversions++;
+    }
+    if (conversions > 1)
+        return false;
+
+    pattern = path;
+    if (conversions == 0) {
+        size_t slash = pattern.find_last_of("/\\");
+        size_t dot = pattern.find_last_of('.');
+        if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+            dot = pattern.size();
+        pattern.insert(dot, "_%06d");
+    }
+    return true;
+}
+
+// ----------------------------
+// Writer thread
+// ----------------------------
+class FrameWriter
+{
+public:
+    ~FrameWriter() { Close(); }
+
+    // Y4M needs even dimensions; odd ones are rounded up. Returns false if
+    // the size is not positive, the PPM pattern is unusable (see
+    // FramePathPattern) or the output cannot be created.
+    bool Open(const char* path, int width, int height, int fps, int queueFrames = CAPTURE_QUEUE_FRAMES)
+    {
+        Close();
+        if (width <= 0 || height <= 0)
+            return false;
+        size_t len = strlen(path);
+        y4m = len >= 4 && strcmp(path + len - 4, ".y4m") == 0;
+        pattern = path;
+        if (!y4m && !FramePathPattern(path, pattern))
+            return false;
+        if (y4m) {
+            width += width & 1;
+            height += height & 1;
+            out = fopen(path, "wb");
+            if (!out)
+                return false;
+            fprintf(out, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", width, height, fps);
+        }
+
+        frameWidth = width;
+        frameHeight = height;
+        buffers.resize(queueFrames);
+        for (int i = 0; i < queueFrames; i++) {
+            buffers[i].width = width;
+            buffers[i].height = height;
+            buffers[i].pixels.assign((size_t)width * height, 0);
+            freeFrames.push_back(&buffers[i]);
+        }
+
+        nextIndex = 0;
+        written = 0;
+        failed = false;
+        stallSeconds = 0.0;
+        quit = false;
+        writerThread = std::thread([this]() { WriterLoop(); });
+        return true;
+    }
+
+    bool IsOpen() const { return writerThread.joinable(); }
+    int Width() const { return frameWidth; }
+    int Height() const { return frameHeight; }
+
+    // Where frames go: the .y4m path or the PPM pattern actually used
+    const char* Path() const { return pattern.c_str(); }
+
+    // A free frame to render into. Blocks only while every buffer is
+    // queued for writing.
+    CaptureFrame* Acquire()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (freeFrames.empty()) {
+            auto begin = std::chrono::steady_clock::now();
+            frameFreed.wait(lock, [this]() { return !freeFrames.empty(); });
+            stallSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        }
+        CaptureFrame* frame = freeFrames.back();
+        freeFrames.pop_back();
+        return frame;
+    }
+
+    // Queues a rendered frame for writing, in submission order
+    void Submit(CaptureFrame* frame)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            frame->index = nextIndex++;
+            readyFrames.push_back(frame);
+        }
+        frameReady.notify_one();
+    }
+
+    // Writes every queued frame, then stops the writer
+    void Close()
+    {
+        if (!writerThread.joinable())
+            return;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            quit = true;
+        }
+        frameReady.notify_one();
+        writerThread.join();
+        if (out)
+            fclose(out);
+        out = nullptr;
+        buffers.clear();
+        freeFrames.clear();
+    }
+
+    long long FramesWritten() const { return written.load(); }
+    bool Failed() const { return failed.load(); }
+
+    // Time the producer spent waiting for a free buffer
+    double StallSeconds() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return stallSeconds;
+    }
+
+private:
+    bool y4m = false;
+    std::string pattern;
+    FILE* out = nullptr;
+    int frameWidth = 0, frameHeight = 0;
+
+    std::vector<CaptureFrame> buffers;
+    std::vector<CaptureFrame*> freeFrames;
+    std::deque<CaptureFrame*> readyFrames;
+    long long nextIndex = 0;
+    double stallSeconds = 0.0;
+    bool quit = false;
+    mutable std::mutex mutex;
+    std::condition_variable frameReady, frameFreed;
+    std::thread writerThread;
+
+    std::atomic<long long> written{0};
+    std::atomic<bool> failed{false};
+    std::vector<uint8_t> scratch;   // writer thread only
+
+    void WriterLoop()
+    {
+        TraceThreadName("frame writer");
+        for (;;) {
+            CaptureFrame* frame;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                frameReady.wait(lock, [this]() { return quit || !readyFrames.empty(); });
+                if (readyFrames.empty())
+                    return;     // quit and drained
+                frame = readyFrames.front();
+                readyFrames.pop_front();
+            }
+
+            {
+                TRACE_SCOPE("write frame");
+                if (!(y4m ? WriteY4m(*frame) : WritePpm(*frame)))
+                    failed = true;
+                else
+                    written++;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                freeFrames.push_back(frame);
+            }
+            frameFreed.notify_one();
+        }
+    }
+
+    // One "FRAME" of planar Y, then U and V at half resolution (each from
+    // the average of a 2x2 block), BT.601 studio range
+    bool WriteY4m(const CaptureFrame& f)
+    {
+        int w = f.width, h = f.height;
+        size_t lumaBytes = (size_t)w * h;
+        size_t chromaBytes = (size_t)(w / 2) * (h / 2);
+        scratch.resize(lumaBytes + 2 * chromaBytes);
+        uint8_t* yPlane = scratch.data();
+        uint8_t* uPlane = yPlane + lumaBytes;
+        uint8_t* vPlane = uPlane + chromaBytes;
+
+        for (size_t i = 0; i < lumaBytes; i++) {
+            uint32_t c = f.pixels[i];
+            int r = (c >> 16) & 0xff, g = (c >> 8) & 0xff, b = c & 0xff;
+            yPlane[i] = (uint8_t)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+        }
+        for (int y = 0; y < h / 2; y++) {
+            const uint32_t* row0 = &f.pixels[(size_t)(2 * y) * w];
+            const uint32_t* row1 = row0 + w;
+            for (int x = 0; x < w / 2; x++) {
+                uint32_t c[4] = { row0[2 * x], row0[2 * x + 1], row1[2 * x], row1[2 * x + 1] };
+                int r = 0, g = 0, b = 0;
+                for (int k = 0; k < 4; k++) {
+                    r += (c[k] >> 16) & 0xff;
+                    g += (c[k] >> 8) & 0xff;
+                    b += c[k] & 0xff;
+                }
+                r = (r + 2) / 4; g = (g + 2) / 4; b = (b + 2) / 4;
+                size_t o = (size_t)y * (w / 2) + x;
+                uPlane[o] = (uint8_t)(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+                vPlane[o] = (uint8_t)(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+            }
+        }
+
+        return fputs("FRAME\n", out) >= 0 &&
+               fwrite(scratch.data(), 1, scratch.size(), out) == scratch.size();
+    }
+
+    // One binary PPM (P6) file per frame
+    bool WritePpm(const CaptureFrame& f)
+    {
+        char path[1024];
+        snprintf(path, sizeof(path), pattern.c_str(), (int)f.index);
+        FILE* file = fopen(path, "wb");
+        if (!file)
+            return false;
+
+        size_t pixels = (size_t)f.width * f.height;
+        scratch.resize(pixels * 3);
+        for (size_t i = 0; i < pixels; i++) {
+            uint32_t c = f.pixels[i];
+            scratch[3 * i] = (uint8_t)(c >> 16);
+            scratch[3 * i + 1] = (uint8_t)(c >> 8);
+            scratch[3 * i + 2] = (uint8_t)c;
+        }
+
+        bool ok = fprintf(file, "P6\n%d %d\n255\n", f.width, f.height) > 0 &&
+                  fwrite(scratch.data(), 1, scratch.size(), file) == scratch.size();
+        if (fclose(file) != 0)
+            ok = false;
+        return ok;
+    }
+};
@@ -0,0 +1,250 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <chrono>
+#include "engine/world.h"
+#include "engine/scenarios.h"
+#include "engine/world_file.h"
+#include "engine/input_replay.h"
+#include "frame_capture.h"
+
+// ----------------------------
+// Headless runner
+// ----------------------------
+// Runs a container scene without a window and without SDL_Delay, as fast
+// as the CPU allows.
+//
+//     headless [balls] [steps] [threads] [--load FILE] [--save FILE]
+//     headless --replay FILE [threads]     (default: as recorded)
+//
+// Either form takes --capture PATH [--size WxH] [--every N] to render every
+// Nth step off-screen and write it as a .y4m video or a PPM sequence
+// ("frames/f_%06d.ppm"); see frame_capture.h.
+//
+// --load starts from a saved world (see engine/world_file.h) instead of a
+// fresh stress scene; --save writes the world after the last step. Settle a
+// big scene once, then measure from the settled state:
+//
+//     headless 1000000 3000 8 --save settled_1m.world
+//     headless 0 600 8 --load settled_1m.world
+//
+// --trace FILE writes a Chrome trace of the run (per phase, per thread;
+// open in chrome://tracing or ui.perfetto.dev). Build with -DENGINE_TRACE,
+// see engine/trace.h.
+//
+// --replay re-runs an input recording of an n_collision session (see
+// engine/input_replay.h) at full speed, reports the slowest tick and whether
+// the replay ended on the recorded positions.
+//
+// Prints the simulated time, the wall-clock time and how much faster than
+// real time the world ran.
+
+// Frame capture settings from the command line
+struct Capture
+{
+    const char* path = nullptr;
+    int width = 1080, height = 1080;
+    int every = 1;              // capture every Nth step
+    FrameWriter writer;
+    CaptureView view;
+
+    bool Open(const World& world, double dt)
+    {
+        if (!path)
+            return true;
+        int fps = (int)(1.0 / (dt * every) + 0.5);
+        if (!writer.Open(path, width, height, fps > 0 ? fps : 1)) {
+            std::string pattern;
+            if (!FramePathPattern(path, pattern))
+                fprintf(stderr, "--capture: %s is not a .y4m path or a PPM pattern with one %%d "
+                        "(e.g. frames/f_%%06d.ppm, %%%% for a literal %%)\n", path);
+            else
+                fprintf(stderr, "cannot write capture %s\n", path);
+            return false;
+        }
+        view = FitView(world.config(), writer.Width(), writer.Height());
+        return true;
+    }
+
+    // After each step
+    void Frame(World& world)
+    {
+        if (!path || world.stats().steps % every != 0)
+            return;
+        CaptureFrame* frame = writer.Acquire();
+        RenderFrame(*frame, world.particles(), view, &world.threadPool(), &world.config());
+        writer.Submit(frame);
+    }
+
+    void Close()
+    {
+        if (!path)
+            return;
+        writer.Close();
+        printf("captured:   %lld frames %dx%d to %s (%.3f s waiting on the writer)%s\n",
+               writer.FramesWritten(), writer.Width(), writer.Height(), writer.Path(),
+               writer.StallSeconds(), writer.Failed() ? ", WRITE ERRORS" : "");
+    }
+};
+
+int Replay(const char* path, int threads, Capture& capture)
+{
+    InputReplay replay;
+    if (!replay.Open(path)) {
+        fprintf(stderr, "cannot read input recording %s\n", path);
+        return 1;
+    }
+    if (replay.Header().scalarBytes != sizeof(Scalar))
+        printf("warning:    recorded with %d byte scalars, replaying with %d\n",
+               (int)replay.Header().scalarBytes, (int)sizeof(Scalar));
+
+    std::unique_ptr<World> world = replay.CreateWorld(threads);
+    if (!capture.Open(*world, replay.Header().tickDt))
+        return 1;
+    double worstTick = 0.0;
+    long long worstTickIndex = 0;
+
+    auto begin = std::chrono::steady_clock::now();
+    auto last = begin;
+    while (replay.Step(*world)) {
+        capture.Frame(*world);
+        auto now = std::chrono::steady_clock::now();
+        double tick = std::chrono::duration<double>(now - last).count();
+        if (tick > worstTick) {
+            worstTick = tick;
+            worstTickIndex = world->stats().steps - 1;
+        }
+        last = now;
+    }
+    double wall = std::chrono::duration<double>(last - begin).count();
+    long long steps = world->stats().steps;
+    double simulated = steps * replay.Header().tickDt;
+
+    printf("replay:     %s (seed %u, %d inputs)\n", path, replay.Header().seed, replay.EventCount());
+    printf("balls:      %d\n", world->ballCount());
+    printf("steps:      %lld (%.2f s simulated)\n", steps, simulated);
+    printf("wall time:  %.3f s\n", wall);
+    printf("steps/sec:  %.1f\n", steps / wall);
+    printf("real time:  %.1fx\n", simulated / wall);
+    printf("worst tick: %.3f ms (tick %lld)\n", worstTick * 1000.0, worstTickIndex);
+    capture.Close();
+    if (replay.Complete())
+        printf("result:     %s\n", replay.Matches(*world) ? "matches the recording" : "DIFFERS from the recording");
+    else
+        printf("result:     recording has no end marker (session crashed?)\n");
+    return 0;
+}
+
+void WriteTrace(const char* path)
+{
+    if (!path)
+        return;
+#ifdef ENGINE_TRACE
+    if (TraceWrite(path))
+        printf("trace:      %s\n", path);
+    else
+        fprintf(stderr, "cannot write trace %s\n", path);
+#else
+    fprintf(stderr, "--trace: built without -DENGINE_TRACE, nothing recorded\n");
+#endif
+}
+
+int main(int argc, char* argv[])
+{
+    const char* loadPath = nullptr;
+    const char* savePath = nullptr;
+    const char* replayPath = nullptr;
+    const char* tracePath = nullptr;
+    Capture capture;
+    const char* positional[3] = { nullptr, nullptr, nullptr };
+    int positionalCount = 0;
+    for (int a = 1; a < argc; a++) {
+        if (strcmp(argv[a], "--load") == 0 && a + 1 < argc)
+            loadPath = argv[++a];
+        else if (strcmp(argv[a], "--save") == 0 && a + 1 < argc)
+            savePath = argv[++a];
+        else if (strcmp(argv[a], "--replay") == 0 && a + 1 < argc)
+            replayPath = argv[++a];
+        else if (strcmp(argv[a], "--trace") == 0 && a + 1 < argc)
+            tracePath = argv[++a];
+        else if (strcmp(argv[a], "--capture") == 0 && a + 1 < argc)
+            capture.path = argv[++a];
+        else if (strcmp(argv[a], "--size") == 0 && a + 1 < argc) {
+            char extra;
+            if (sscanf(argv[++a], "%dx%d%c", &capture.width, &capture.height, &extra) != 2 ||
+                capture.width <= 0 || capture.height <= 0 ||
+                capture.width > CAPTURE_MAX_SIZE || capture.height > CAPTURE_MAX_SIZE) {
+                fprintf(stderr, "--size takes WIDTHxHEIGHT, 1 to %d each (e.g. 1920x1080)\n", CAPTURE_MAX_SIZE);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[a], "--every") == 0 && a + 1 < argc)
+            capture.every = atoi(argv[++a]) > 0 ? atoi(argv[a]) : 1;
+        else if (positionalCount < 3)
+            positional[positionalCount++] = argv[a];
+    }
+
+    int ballCount = positional[0] ? atoi(positional[0]) : 200;
+    int steps = positional[1] ? atoi(positional[1]) : 600;
+    int threads = positional[2] ? atoi(positional[2]) : 1;
+    double dt = 1.0 / 60.0;
+
+    TraceThreadName("main");
+    if (replayPath) {
+        int result = Replay(replayPath, positional[0] ? atoi(positional[0]) : 0, capture);
+        WriteTrace(tracePath);
+        return result;
+    }
+
+    std::unique_ptr<World> world;
+    if (loadPath) {
+        auto loadBegin = std::chrono::steady_clock::now();
+        WorldFile file;
+        if (!file.Open(loadPath)) {
+            fprintf(stderr, "cannot load world file %s\n", loadPath);
+            return 1;
+        }
+        WorldConfig config = file.Config();
+        config.threads = threads;
+        world.reset(new World(config));
+        file.LoadInto(*world);
+        double loadTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - loadBegin).count();
+        printf("loaded:     %s (%.1f ms)\n", loadPath, loadTime * 1000.0);
+    } else {
+        // Container sized for the ball count (see engine/scenarios.h)
+        world = CreateStressWorld(ballCount, threads, 1);
+    }
+
+    if (!capture.Open(*world, dt))
+        return 1;
+
+    auto begin = std::chrono::steady_clock::now();
+    for (int s = 0; s < steps; s++) {
+        world->step(dt);
+        capture.Frame(*world);
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double wall = std::chrono::duration<double>(end - begin).count();
+    double simulated = steps * dt;
+
+    printf("balls:      %d\n", world->ballCount());
+    printf("steps:      %d (%.2f s simulated)\n", steps, simulated);
+    printf("wall time:  %.3f s\n", wall);
+    printf("steps/sec:  %.1f\n", steps / wall);
+    printf("real time:  %.1fx\n", simulated / wall);
+    capture.Close();
+    WriteTrace(tracePath);
+
+    if (savePath) {
+        if (!SaveWorld(*world, savePath)) {
+            fprintf(stderr, "cannot write world file %s\n", savePath);
+            return 1;
+        }
+        printf("saved:      %s (step %lld)\n", savePath, world->stats().steps);
+    }
+    return 0;
+}
+
+// g++ headless.cpp -o headless -O2 -mavx2 -pthread
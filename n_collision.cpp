@@ -1,212 +1,73 @@
 #include <stdio.h>
-#include <vector>
+#include <time.h>
 #include <SDL2/SDL.h>
 #include <math.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "engine/world.h"
+#include "sdl_draw.h"
+#include "tiled_renderer.h"
+#include "engine/snapshot.h"
+#include "engine/event_log.h"
+#include "engine/input_replay.h"
 
 // Window size
 #define WIDTH 600
 #define HEIGHT 600
 
-// Colors
-#define COLOR_WHITE 0xffffffff
-#define COLOR_BLACK 0x00000000
-
 // Physics constants
 #define GRAVITY 0.5
 #define ELASTICITY 0.9   // 1.0 = perfectly elastic
 #define BALL_COUNT 200
 #define SUBSTEP_COUNT 8
-// ----------------------------
-// Circle structure
-// ----------------------------
-// x, y       -> current position
-// oldx, oldy -> previous position (used to infer velocity)
-// radius     -> circle size
-struct Circle
+#define USE_CCD 0           // 1 = sweep fast balls (engine/ccd.h), stable with SUBSTEP_COUNT 2
+#define USE_BRUTE_FORCE 0   // 1 = test every pair (reference path)
+#define THREAD_COUNT 0      // collision / render threads, 0 = one per core
+#define PHYSICS_HZ 60       // fixed physics tick
+#define RENDER_HZ 144       // render loop rate, interpolated between ticks
+#define USE_SLEEPING 1      // 1 = freeze piles that have come to rest
+#define BALL_CAPACITY 8192  // preallocated, spawning by drag never reallocates
+#define EVENT_LOG_FILE NULL // e.g. "events.log"; NULL = input events to stdout
+#define INPUT_RECORD_FILE NULL  // e.g. "session.input"; NULL = don't record
+#define RNG_SEED 0          // spawn radii seed, 0 = from the clock (recorded)
+#define TRACE_FILE "n_collision_trace.json" // written on exit when built with -DENGINE_TRACE
+
+// Container circle, fixed at compile time (see engine/policies.h)
+struct Container
 {
-    double x, y;
-    double oldx, oldy;
-    double radius;
-    Uint32 color;
+    static constexpr double x = WIDTH / 2;
+    static constexpr double y = HEIGHT / 2;
+    static constexpr double radius = 250;
 };
 
-Uint32 getRainbow(SDL_Surface* surface, float t)
-{
-    float r = sinf(t);
-    float g = sinf(t + 0.33f * 2.0f * M_PI);
-    float b = sinf(t + 0.66f * 2.0f * M_PI);
-
-    Uint8 R = (Uint8)(255.0f * r * r);
-    Uint8 G = (Uint8)(255.0f * g * g);
-    Uint8 B = (Uint8)(255.0f * b * b);
-
-    return SDL_MapRGB(surface->format, R, G, B);
-}
-
-
-// ----------------------------
-// Filled circle rendering
-// ----------------------------
-void FillCircle(SDL_Surface* surface, Circle circle, Uint32 color)
-{
-    double r2 = circle.radius * circle.radius;
-
-    for (int x = circle.x - circle.radius; x <= circle.x + circle.radius; x++) {
-        for (int y = circle.y - circle.radius; y <= circle.y + circle.radius; y++) {
-            double dx = x - circle.x;
-            double dy = y - circle.y;
-            if (dx*dx + dy*dy <= r2) {
-                SDL_Rect pixel = { x, y, 1, 1 };
-                SDL_FillRect(surface, &pixel, color);
-            }
-        }
-    }
-}
+typedef BasicWorld<Scalar, CircleContainer<Container> > DemoWorld;
 
 // ----------------------------
-// Draw outline of container circle
+// Mouse input
 // ----------------------------
-void DrawCircleOutline(SDL_Surface* surface, Circle circle, Uint32 color)
+// Recorded by the SDL thread, applied by the physics thread between ticks
+// (ApplyInput, engine/input_replay.h). Events go to an asynchronous log (the
+// physics thread is its only producer), so a drag never waits on the
+// terminal. With INPUT_RECORD_FILE set, every input is also recorded with
+// its tick; replay the session with headless --replay FILE.
+void LogInput(EventLog& log, const InputCommand& input, const InputResult& result)
 {
-    double rOuter = circle.radius * circle.radius;
-    double rInner = (circle.radius - 1) * (circle.radius - 1);
-
-    for (int x = circle.x - circle.radius; x <= circle.x + circle.radius; x++) {
-        for (int y = circle.y - circle.radius; y <= circle.y + circle.radius; y++) {
-            double dx = x - circle.x;
-            double dy = y - circle.y;
-            double d = dx*dx + dy*dy;
-            if (d <= rOuter && d >= rInner) {
-                SDL_Rect pixel = { x, y, 1, 1 };
-                SDL_FillRect(surface, &pixel, color);
-            }
+    if (input.type == INPUT_CLICK) {
+        LOG_INFO(log, "Mouse Clicked at (%d, %d)", input.x, input.y);
+        if (result.removed >= 0) {
+            LOG_INFO(log, "Ball %d clicked!", result.removed);
+            LOG_INFO(log, "Ball Color: 0x%X", result.removedColor);
         }
+    } else {
+        LOG_DEBUG(log, "Mouse Dragged at (%d, %d)", input.x, input.y);
+        if (result.removed >= 0)
+            LOG_INFO(log, "Ball %d dragged and removed!", result.removed);
     }
 }
 
-// ----------------------------
-// Verlet integration step
-// ----------------------------
-void UpdateCircle(Circle& c)
-{
-    double vx = c.x - c.oldx;
-    double vy = c.y - c.oldy;
-
-    // Store current position
-    c.oldx = c.x;
-    c.oldy = c.y;
-
-    // Integrate position (gravity acts downward)
-    c.x += vx;
-    c.y += vy + GRAVITY;
-}
-
-// ----------------------------
-// Circular container constraint
-// ----------------------------
-void ApplyCircularConstraint(Circle& particle, const Circle& container)
-{
-    // Capture velocity FIRST (before modifying position)
-    double vx = particle.x - particle.oldx;
-    double vy = particle.y - particle.oldy;
-
-    // Vector from container center to particle
-    double dx = particle.x - container.x;
-    double dy = particle.y - container.y;
-
-    double dist = sqrt(dx*dx + dy*dy);
-    double maxDist = container.radius - particle.radius;
-
-    // If particle escapes container
-    if (dist > maxDist) {
-        // Normal vector
-        double nx = dx / dist;
-        double ny = dy / dist;
-
-        // Snap particle back onto boundary
-        particle.x = container.x + nx * maxDist;
-        particle.y = container.y + ny * maxDist;
-
-        // Reflect velocity across normal
-        double dot = vx * nx + vy * ny;
-        vx -= 2.0 * dot * nx;
-        vy -= 2.0 * dot * ny;
-
-        // Apply elasticity
-        vx *= ELASTICITY;
-        vy *= ELASTICITY;
-
-        // Reconstruct previous position
-        particle.oldx = particle.x - vx;
-        particle.oldy = particle.y - vy;
-    }
-}
-
-
-// Applying Collisions
-void ResolveBallCollision(Circle& a, Circle& b)
-{
-    // Vector between centers
-    double dx = b.x - a.x;
-    double dy = b.y - a.y;
-
-    double dist = sqrt(dx*dx + dy*dy);
-    double minDist = a.radius + b.radius;
-
-    // No collision
-    if (dist >= minDist || dist == 0.0)
-        return;
-
-    // Normalized collision normal
-    double nx = dx / dist;
-    double ny = dy / dist;
-
-    // -------- POSITION CORRECTION --------
-    double overlap = minDist - dist;
-    double correction = overlap * 0.5;
-
-    a.x -= nx * correction;
-    a.y -= ny * correction;
-    b.x += nx * correction;
-    b.y += ny * correction;
-
-    // -------- VELOCITY (VERLET STYLE) --------
-    double avx = a.x - a.oldx;
-    double avy = a.y - a.oldy;
-    double bvx = b.x - b.oldx;
-    double bvy = b.y - b.oldy;
-
-    // Relative velocity
-    double rvx = bvx - avx;
-    double rvy = bvy - avy;
-
-    // Velocity along normal
-    double velAlongNormal = rvx * nx + rvy * ny;
-
-    // If balls are separating, don't resolve
-    if (velAlongNormal > 0)
-        return;
-
-    // Elastic response
-    double impulse = -(1.0 + ELASTICITY) * velAlongNormal;
-    impulse *= 0.5; // equal mass
-
-    double ix = impulse * nx;
-    double iy = impulse * ny;
-
-    avx -= ix;
-    avy -= iy;
-    bvx += ix;
-    bvy += iy;
-
-    // Reconstruct old positions
-    a.oldx = a.x - avx;
-    a.oldy = a.y - avy;
-    b.oldx = b.x - bvx;
-    b.oldy = b.y - bvy;
-}
-
-
 // ----------------------------
 // Main
 // ----------------------------
@@ -226,9 +87,24 @@ int main(int argc, char* argv[])
 
     // Container circle
     Circle container;
-    container.x = WIDTH / 2;
-    container.y = HEIGHT / 2;
-    container.radius = 250;
+    container.x = Container::x;
+    container.y = Container::y;
+    container.radius = Container::radius;
+
+    // Physics world (GRAVITY is px per frame^2 at 60 Hz)
+    WorldConfig config;
+    config.gravity = GRAVITY * 60.0 * 60.0;
+    config.elasticity = ELASTICITY;
+    config.substeps = SUBSTEP_COUNT;
+    config.bruteForce = USE_BRUTE_FORCE;
+    config.threads = THREAD_COUNT;
+    config.sleeping = USE_SLEEPING;
+    config.ccd = USE_CCD;
+    config.capacity = BALL_CAPACITY;
+    config.containerX = Container::x;   // recorded for replays
+    config.containerY = Container::y;
+    config.containerRadius = Container::radius;
+    DemoWorld world(config);
 
     // Particle
 //     Circle ball;
@@ -239,138 +115,130 @@ int main(int argc, char* argv[])
 //     ball.radius = 40;
 
 
-    std::vector<Circle> balls;
-    // Vector - used to store multiple balls if needed
-    // <Circle> - template for Circle structure
-    // balls - name of the vector
-float colorTime = 0.0f;
-float colorStep = 0.15f; // smaller = smoother rainbow
-
-for (int i = 0; i < BALL_COUNT; i++) {
-    Circle b;
-
-    b.x = 300 + i * 2;
-    b.y = 100 + i * 2;
-    b.oldx = b.x;
-    b.oldy = b.y;
-    b.radius = 6 + (rand() % 15); // Random radius between 6 and 20
-    // b.radius = 5;
+    // Structure of arrays - positions, old positions and radii each live
+    // in their own array, colors in a side table (see engine/particle_store.h).
+    // Radii come from a seeded generator so a recording can rebuild the
+    // same line (engine/scenarios.h).
+    uint32_t seed = RNG_SEED ? RNG_SEED : (uint32_t)time(NULL);
+    ScenarioRng rng(seed);
+    SpawnDemoLine(world, BALL_COUNT, 15, rng);   // radius 6 to 20
+
+    ParticleStore& balls = world.particles();
+    float colorTime = 0.0f;
+    float colorStep = 0.15f; // smaller = smoother rainbow
+    for (int i = 0; i < balls.size(); i++) {
+        balls.color[i] = getRainbow(surface, colorTime);
+        colorTime += colorStep;
+    }
 
-    b.color = getRainbow(surface, colorTime);
-    colorTime += colorStep;
+    // Physics runs on its own thread at PHYSICS_HZ and publishes snapshots;
+    // this thread handles input and draws, interpolating between the last
+    // two ticks. Input is queued and applied by the physics thread at the
+    // start of its next tick.
+    std::mutex inputMutex;
+    std::vector<InputCommand> inputQueue;
+    SnapshotPublisher publisher;
+    std::atomic<bool> running(true);
+
+    EventLog eventLog;
+    if (EVENT_LOG_FILE)
+        eventLog.OpenFile(EVENT_LOG_FILE);
+
+    const double tickDt = 1.0 / PHYSICS_HZ;
+    InputRecorder recorder;
+    if (INPUT_RECORD_FILE)
+        recorder.Open(INPUT_RECORD_FILE, MakeInputLogHeader(world, seed, BALL_COUNT, 15, tickDt));
+
+    auto startTime = std::chrono::steady_clock::now();
+    auto secondsSinceStart = [&]() {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    };
+
+    publisher.Publish(world, secondsSinceStart(), true);
+
+    std::thread physicsThread([&]() {
+        TraceThreadName("physics");
+        std::vector<InputCommand> commands;
+        auto nextTick = std::chrono::steady_clock::now();
+        auto tickLength = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(tickDt));
+
+        while (running.load()) {
+            {
+                std::lock_guard<std::mutex> lock(inputMutex);
+                commands.swap(inputQueue);
+            }
+            bool structureChanged = !commands.empty();
+            for (size_t i = 0; i < commands.size(); i++) {
+                recorder.Record(world.stats().steps, commands[i]);
+                LogInput(eventLog, commands[i], ApplyInput(world, rng, commands[i]));
+            }
+            commands.clear();
+
+            // Integrate, then SUBSTEP_COUNT rounds of collisions + constraint
+            world.step(tickDt);
+            publisher.Publish(world, secondsSinceStart(), structureChanged);
+
+            // Fixed tick; if we fell far behind, don't try to catch up
+            nextTick += tickLength;
+            auto now = std::chrono::steady_clock::now();
+            if (now - nextTick > 4 * tickLength)
+                nextTick = now;
+            std::this_thread::sleep_until(nextTick);
+        }
+    });
 
-    balls.push_back(b);
-}
+    // Render threads are separate from the collision threads: both run at
+    // the same time now
+    ThreadPool renderPool(THREAD_COUNT);
+    TiledRenderer renderer;
+    ParticleStore frame;    // interpolated positions for drawing
 
-    int running = 1;
     SDL_Event event;
+    TraceThreadName("render");
 
-    while (running) {
+    while (running.load()) {
         while (SDL_PollEvent(&event)) {
             if (event.type == SDL_QUIT)
-                running = 0;
+                running = false;
             if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_ESCAPE)
-                running = 0;
+                running = false;
             if (event.type == SDL_MOUSEBUTTONDOWN) {
-               printf("Mouse Clicked at (%d, %d)\n", event.button.x, event.button.y);
-            //    If ball is clicked, remove the ball
-            int BALL_CLICKED = 0;
-               for (int i = 0; i < balls.size(); i++) {
-                     double dx = balls[i].x - event.button.x;
-                     double dy = balls[i].y - event.button.y;
-                     double dist2 = dx*dx + dy*dy;
-                     if (dist2 < balls[i].radius * balls[i].radius) {
-                         printf("Ball %d clicked!\n", i);
-                         printf("Ball Color: 0x%X\n", balls[i].color);
-                         balls[i].color = COLOR_WHITE; // Change color on click
-                        //  Remove the ball on click
-                         balls.erase(balls.begin() + i);
-                            BALL_CLICKED = 1;
-                            break;
-                     }
-               }
-                if (BALL_CLICKED == 0) {
-// Open, so add a new ball at mouse position
-                Circle newBall;
-                newBall.x = event.button.x;
-                newBall.y = event.button.y;
-                newBall.oldx = newBall.x;
-                newBall.oldy = newBall.y;
-                newBall.radius = 10 + (rand() % 10);
-                // newBall.radius = 5;
-                // newBall.color = getRainbow(surface, colorTime);
-                newBall.color = 0xffffffff;
-                colorTime += colorStep;
-                balls.push_back(newBall);
-                
-                }
-                
-
+                std::lock_guard<std::mutex> lock(inputMutex);
+                inputQueue.push_back(InputCommand{ INPUT_CLICK, event.button.x, event.button.y });
             }
-
             if (event.type == SDL_MOUSEMOTION && (event.motion.state != 0)) {
-                // If dragging on ball, delete ball
-                 printf("Mouse Dragged at (%d, %d)\n", event.motion.x, event.motion.y);
-                 int BALL_DRAGGED = 0;
-                    for (int i = 0; i < balls.size(); i++) {
-                        double dx = balls[i].x - event.motion.x;
-                        double dy = balls[i].y - event.motion.y;
-                        double dist2 = dx*dx + dy*dy;
-                        if (dist2 < balls[i].radius * balls[i].radius) {
-                            printf("Ball %d dragged and removed!\n", i);
-                            balls.erase(balls.begin() + i);
-                            BALL_DRAGGED = 1;
-                            break;
-                        }
-                    }
-                if (BALL_DRAGGED == 0) {
-               // Drag to add multiple balls
-                Circle newBall;
-                newBall.x = event.motion.x;
-                newBall.y = event.motion.y;
-                newBall.oldx = newBall.x;
-                newBall.oldy = newBall.y;
-                newBall.radius = 6 + (rand() % 10);
-                // newBall.radius = 5;
-                // newBall.color = getRainbow(surface, colorTime);
-                newBall.color = 0xffffffff;
-                colorTime += colorStep;
-                balls.push_back(newBall);}
-            }
-        }
-
-        SDL_FillRect(surface, NULL, COLOR_BLACK);
-
-            for (int i = 0; i < balls.size(); i++) {
-        UpdateCircle(balls[i]);
-    } // Update all balls
-        
-
-        // Solve constraints & collisions multiple times
-        // SUB-STEPPING FOR STABILITY
-        for (int i = 0; i < SUBSTEP_COUNT; i++) {
-            for (int i = 0; i < balls.size(); i++) {
-                for (int j = i + 1; j < balls.size(); j++) {
-                    ResolveBallCollision(balls[i], balls[j]);
-                }
-            ApplyCircularConstraint(balls[i], container);
+                std::lock_guard<std::mutex> lock(inputMutex);
+                inputQueue.push_back(InputCommand{ INPUT_DRAG, event.motion.x, event.motion.y });
             }
         }
 
+        // Latest snapshot, drawn one tick behind so there is always a
+        // "next" position to blend towards
+        publisher.buffer.Update();
+        const WorldSnapshot& snapshot = publisher.buffer.ReadBuffer();
+        double alpha = (secondsSinceStart() - snapshot.time) / tickDt;
+        InterpolateSnapshot(snapshot, alpha, frame);
 
+        SDL_FillRect(surface, NULL, COLOR_BLACK);
 
         // Render
-        for (int i = 0; i < balls.size(); i++) {
-    FillCircle(surface, balls[i], balls[i].color);
-}
+        renderer.Draw(surface, frame, renderPool);
         DrawCircleOutline(surface, container, 0XCCCCCC);
 
-        SDL_UpdateWindowSurface(window);
-        SDL_Delay(16); // ~60 FPS
+        {
+            TRACE_SCOPE("SDL_UpdateWindowSurface");
+            SDL_UpdateWindowSurface(window);
+        }
+        SDL_Delay(1000 / RENDER_HZ);
     }
 
+    physicsThread.join();
+    recorder.Close(world);
+    TraceWrite(TRACE_FILE);
+
     SDL_Quit();
     return 0;
 }
 
-// g++ n_collision.cpp -o n_collision -I C:/MinGW/include -L C:/MinGW/lib -lmingw32 -lSDL2main -lSDL2 -lm
\ No newline at end of file
+// g++ n_collision.cpp -o n_collision -I C:/MinGW/include -L C:/MinGW/lib -lmingw32 -lSDL2main -lSDL2 -lm -O2 -mavx2 -pthread
\ No newline at end of file
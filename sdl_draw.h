@@ -0,0 +1,155 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <math.h>
+#include <vector>
+#include "engine/particle_store.h"
+#include "engine/perf_counters.h"
+#include "engine/trace.h"
+#include "span_raster.h"
+
+// Drawing helpers shared by the SDL frontends. The physics lives in
+// engine/world.h; nothing in here affects the simulation.
+
+// Colors
+#define COLOR_WHITE 0xffffffff
+#define COLOR_BLACK 0x00000000
+
+// ----------------------------
+// Circle structure
+// ----------------------------
+// x, y       -> current position
+// oldx, oldy -> previous position (used to infer velocity)
+// radius     -> circle size
+struct Circle
+{
+    double x, y;
+    double oldx, oldy;
+    double radius;
+    Uint32 color;
+};
+
+inline Uint32 getRainbow(SDL_Surface* surface, float t)
+{
+    float r = sinf(t);
+    float g = sinf(t + 0.33f * 2.0f * M_PI);
+    float b = sinf(t + 0.66f * 2.0f * M_PI);
+
+    Uint8 R = (Uint8)(255.0f * r * r);
+    Uint8 G = (Uint8)(255.0f * g * g);
+    Uint8 B = (Uint8)(255.0f * b * b);
+
+    return SDL_MapRGB(surface->format, R, G, B);
+}
+
+// ----------------------------
+// Pixel target
+// ----------------------------
+// Where the span rasterizer writes: the surface's pixel buffer plus a clip
+// rectangle [clipX0, clipX1) x [clipY0, clipY1). For 32-bit surfaces spans
+// are written straight into the locked pixel buffer; any other format falls
+// back to one SDL_FillRect per span (still one call per row, not per pixel).
+struct PixelTarget
+{
+    SDL_Surface* surface;
+    Uint8* pixels;
+    int pitch;
+    int clipX0, clipY0, clipX1, clipY1;
+    bool direct;
+};
+
+// The surface must be locked (see SurfaceLock) while the target is used.
+inline PixelTarget MakePixelTarget(SDL_Surface* surface)
+{
+    PixelTarget t;
+    t.surface = surface;
+    t.pixels = (Uint8*)surface->pixels;
+    t.pitch = surface->pitch;
+    t.clipX0 = 0;
+    t.clipY0 = 0;
+    t.clipX1 = surface->w;
+    t.clipY1 = surface->h;
+    t.direct = (surface->format->BytesPerPixel == 4 && t.pixels != NULL);
+    return t;
+}
+
+// Locks the surface for the lifetime of the object, if SDL requires it
+struct SurfaceLock
+{
+    SDL_Surface* surface;
+    bool locked;
+
+    explicit SurfaceLock(SDL_Surface* s) : surface(s), locked(false)
+    {
+        if (SDL_MUSTLOCK(surface))
+            locked = (SDL_LockSurface(surface) == 0);
+    }
+    ~SurfaceLock()
+    {
+        if (locked)
+            SDL_UnlockSurface(surface);
+    }
+};
+
+// ----------------------------
+// Horizontal span
+// ----------------------------
+// Fills pixels x0..x1 (inclusive) of row y, clipped once against the target.
+inline void FillSpan(const PixelTarget& t, int y, int x0, int x1, Uint32 color)
+{
+    if (y < t.clipY0 || y >= t.clipY1)
+        return;
+    if (x0 < t.clipX0) x0 = t.clipX0;
+    if (x1 >= t.clipX1) x1 = t.clipX1 - 1;
+    if (x0 > x1)
+        return;
+
+    if (t.direct) {
+        Uint32* row = (Uint32*)(t.pixels + (size_t)y * t.pitch);
+        for (int x = x0; x <= x1; x++)
+            row[x] = color;
+    } else {
+        SDL_Rect span = { x0, y, x1 - x0 + 1, 1 };
+        SDL_FillRect(t.surface, &span, color);
+    }
+}
+
+// ----------------------------
+// Filled circle rendering
+// ----------------------------
+inline void FillCircle(SDL_Surface* surface, const Circle& circle, Uint32 color)
+{
+    TRACE_SCOPE("FillCircle");
+    SurfaceLock lock(surface);
+    SpanTables& tables = GlobalSpanTables();
+    tables.Reserve((int)circle.radius);
+    FillCircleSpans(MakePixelTarget(surface), tables, circle.x, circle.y, circle.radius, color);
+}
+
+// ----------------------------
+// Draw outline of container circle
+// ----------------------------
+inline void DrawCircleOutline(SDL_Surface* surface, const Circle& circle, Uint32 color)
+{
+    TRACE_SCOPE("DrawCircleOutline");
+    SurfaceLock lock(surface);
+    DrawRingSpans(MakePixelTarget(surface), circle.x, circle.y, circle.radius, color);
+}
+
+// ----------------------------
+// Draw every ball of a particle store
+// ----------------------------
+// Locks the surface once for all balls.
+inline void DrawBalls(SDL_Surface* surface, const ParticleStore& balls)
+{
+    TRACE_SCOPE("FillCircle");
+    PERF_SCOPE(PERF_RENDER);
+    SurfaceLock lock(surface);
+    PixelTarget target = MakePixelTarget(surface);
+    SpanTables& tables = GlobalSpanTables();
+
+    for (int i = 0; i < balls.size(); i++) {
+        tables.Reserve((int)balls.radius[i]);
+        FillCircleSpans(target, tables, balls.x[i], balls.y[i], balls.radius[i], balls.color[i]);
+    }
+}
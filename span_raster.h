@@ -0,0 +1,166 @@
+#pragma once
+
+#include <stdint.h>
+#include <math.h>
+#include <vector>
+
+// ----------------------------
+// Span rasterizer
+// ----------------------------
+// Circle and ring rasterization as horizontal spans, independent of where
+// the pixels go. A Target is any struct with a clip rectangle
+// [clipX0, clipX1) x [clipY0, clipY1) and a matching
+//
+//     void FillSpan(const Target& t, int y, int x0, int x1, uint32_t color);
+//
+// sdl_draw.h provides one for SDL surfaces (PixelTarget), frame_capture.h
+// one for off-screen frames.
+
+// ----------------------------
+// Span tables per integer radius
+// ----------------------------
+// For radius r, entry dy (0..r) is the half width of the filled row dy
+// pixels away from the center: the largest dx with dx*dx + dy*dy <= r*r.
+// Built once per radius; every ball of that radius reuses it, so drawing a
+// ball is one table lookup and one span fill per row - no sqrt, no
+// per-pixel test.
+#define SPAN_TABLE_MAX_RADIUS 256
+
+struct SpanTables
+{
+    std::vector<int> start;       // offset of radius r's table in halfWidth
+    std::vector<int> halfWidth;
+
+    // Makes sure tables up to maxRadius exist. Not thread-safe: call it
+    // before handing the tables to several threads.
+    void Reserve(int maxRadius)
+    {
+        if (maxRadius > SPAN_TABLE_MAX_RADIUS)
+            maxRadius = SPAN_TABLE_MAX_RADIUS;
+
+        for (int r = (int)start.size(); r <= maxRadius; r++) {
+            start.push_back((int)halfWidth.size());
+            for (int dy = 0; dy <= r; dy++) {
+                int hw = (int)sqrt((double)(r * r - dy * dy));
+                // Fix rounding of sqrt at exact squares
+                while (hw * hw + dy * dy > r * r) hw--;
+                while ((hw + 1) * (hw + 1) + dy * dy <= r * r) hw++;
+                halfWidth.push_back(hw);
+            }
+        }
+    }
+
+    const int* Get(int r) const { return &halfWidth[start[r]]; }
+    bool Has(int r) const { return r >= 0 && r < (int)start.size(); }
+};
+
+inline SpanTables& GlobalSpanTables()
+{
+    static SpanTables tables;
+    return tables;
+}
+
+// ----------------------------
+// Row span of a circle
+// ----------------------------
+// Pixels x of a row with (x - cx)^2 + dy2 <= limit (or < limit when strict).
+// The sqrt gives the edges, then they are nudged with the exact per-pixel
+// test so rounding never adds or drops an edge pixel.
+// Returns false if the row has no such pixel.
+inline bool RowSpan(double cx, double dy2, double limit, bool strict, int& left, int& right)
+{
+    if (strict ? !(dy2 < limit) : !(dy2 <= limit))
+        return false;
+
+    double hw = sqrt(limit - dy2);
+    left = (int)ceil(cx - hw);
+    right = (int)floor(cx + hw);
+
+    auto inside = [&](int x) {
+        double d = (x - cx) * (x - cx) + dy2;
+        return strict ? d < limit : d <= limit;
+    };
+    while (inside(left - 1)) left--;
+    while (left <= right && !inside(left)) left++;
+    while (inside(right + 1)) right++;
+    while (right >= left && !inside(right)) right--;
+
+    return left <= right;
+}
+
+// ----------------------------
+// Filled circle rendering (spans)
+// ----------------------------
+// Integer radii use the span table with the center rounded to the nearest
+// pixel. Other radii compute each row's span from the exact center.
+template <typename Target>
+inline void FillCircleSpans(const Target& t, const SpanTables& tables,
+                            double cx, double cy, double radius, uint32_t color)
+{
+    int r = (int)radius;
+
+    if (r == radius && tables.Has(r)) {
+        const int* halfWidth = tables.Get(r);
+        int icx = (int)floor(cx + 0.5);
+        int icy = (int)floor(cy + 0.5);
+
+        // Rows outside the clip rect are skipped up front
+        int dy0 = -r, dy1 = r;
+        if (icy + dy0 < t.clipY0) dy0 = t.clipY0 - icy;
+        if (icy + dy1 >= t.clipY1) dy1 = t.clipY1 - 1 - icy;
+
+        for (int dy = dy0; dy <= dy1; dy++) {
+            int hw = halfWidth[dy < 0 ? -dy : dy];
+            FillSpan(t, icy + dy, icx - hw, icx + hw, color);
+        }
+        return;
+    }
+
+    double r2 = radius * radius;
+    int y0 = (int)floor(cy - radius);
+    int y1 = (int)ceil(cy + radius);
+    if (y0 < t.clipY0) y0 = t.clipY0;
+    if (y1 >= t.clipY1) y1 = t.clipY1 - 1;
+
+    for (int y = y0; y <= y1; y++) {
+        double dy = y - cy;
+        int left, right;
+        if (RowSpan(cx, dy * dy, r2, false, left, right))
+            FillSpan(t, y, left, right, color);
+    }
+}
+
+// ----------------------------
+// Circle outline rendering (spans)
+// ----------------------------
+// One pixel wide ring between radius - 1 and radius: per row, the outer
+// span minus the inner one, i.e. at most two short spans.
+template <typename Target>
+inline void DrawRingSpans(const Target& t, double cx, double cy, double radius,
+                          uint32_t color)
+{
+    double rOuter = radius * radius;
+    double rInner = (radius - 1) * (radius - 1);
+
+    int y0 = (int)floor(cy - radius);
+    int y1 = (int)ceil(cy + radius);
+    if (y0 < t.clipY0) y0 = t.clipY0;
+    if (y1 >= t.clipY1) y1 = t.clipY1 - 1;
+
+    for (int y = y0; y <= y1; y++) {
+        double dy = y - cy;
+        int left, right;
+        if (!RowSpan(cx, dy * dy, rOuter, false, left, right))
+            continue;
+
+        // Pixels strictly inside the inner circle are skipped
+        int innerLeft, innerRight;
+        if (!RowSpan(cx, dy * dy, rInner, true, innerLeft, innerRight)) {
+            FillSpan(t, y, left, right, color);
+            continue;
+        }
+
+        FillSpan(t, y, left, innerLeft - 1, color);
+        FillSpan(t, y, innerRight + 1, right, color);
+    }
+}
@@ -0,0 +1,85 @@
+#include <stdio.h>
+#include "../engine/world.h"
+
+// ----------------------------
+// Continuous collision regression tests
+// ----------------------------
+// Plain executable, exit code 0 = every check passed:
+//
+//     g++ tests/ccd_test.cpp -o ccd_test -O1 -pthread -D_GLIBCXX_ASSERTIONS
+//     ./ccd_test
+
+static int failures = 0;
+
+#define CHECK(cond)                                                          \
+    do {                                                                     \
+        if (!(cond)) {                                                       \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            failures++;                                                      \
+        }                                                                    \
+    } while (0)
+
+// Pairs of small balls crossing the circle head-on, several radii per step
+static void AddCrossingPairs(World& world, double dt)
+{
+    for (int k = 0; k < 10; k++) {
+        double y = 200.0 + k * 20.0;
+        world.addBall(100.0, y, 3000.0, 0.0, dt, 3.0);
+        world.addBall(500.0, y, -3000.0, 0.0, dt, 3.0);
+    }
+}
+
+static WorldConfig FastConfig(bool collisions)
+{
+    WorldConfig config;
+    config.gravity = 0.0;
+    config.substeps = 1;
+    config.threads = 1;
+    config.ccd = true;
+    config.collisions = collisions;
+    return config;
+}
+
+// Collisions off: balls pass through each other, only the container is swept
+static void TestNoBallImpactsWithCollisionsOff()
+{
+    const double dt = 1.0 / 60.0;
+    World world(FastConfig(false));
+    AddCrossingPairs(world, dt);
+
+    int containerImpacts = 0;
+    for (int s = 0; s < 120; s++) {
+        world.step(dt);
+        CHECK(world.stats().sweptBallImpacts == 0);
+        containerImpacts += world.stats().sweptImpacts;
+    }
+    CHECK(containerImpacts > 0);
+}
+
+// Same world with collisions on: the sweep does catch the pairs
+static void TestBallImpactsWithCollisionsOn()
+{
+    const double dt = 1.0 / 60.0;
+    World world(FastConfig(true));
+    AddCrossingPairs(world, dt);
+
+    int ballImpacts = 0;
+    for (int s = 0; s < 120; s++) {
+        world.step(dt);
+        ballImpacts += world.stats().sweptBallImpacts;
+    }
+    CHECK(ballImpacts > 0);
+}
+
+int main()
+{
+    TestNoBallImpactsWithCollisionsOff();
+    TestBallImpactsWithCollisionsOn();
+
+    if (failures > 0) {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("ccd tests passed\n");
+    return 0;
+}
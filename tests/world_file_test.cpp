@@ -0,0 +1,150 @@
+#include <stdio.h>
+#include <stdint.h>
+#include "../engine/world.h"
+#include "../engine/world_file.h"
+
+// ----------------------------
+// World file regression tests
+// ----------------------------
+// Plain executable, exit code 0 = every check passed:
+//
+//     g++ tests/world_file_test.cpp -o world_file_test -O1 -pthread -D_GLIBCXX_ASSERTIONS
+//     ./world_file_test
+
+#define TEST_FILE "world_file_test.world"
+
+static int failures = 0;
+
+#define CHECK(cond)                                                          \
+    do {                                                                     \
+        if (!(cond)) {                                                       \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            failures++;                                                      \
+        }                                                                    \
+    } while (0)
+
+// 200 separated balls in an open world without gravity: all asleep after
+// sleepSteps + a few steps
+static WorldConfig SleepyConfig()
+{
+    WorldConfig config;
+    config.container = CONTAINER_NONE;
+    config.gravity = 0.0;
+    config.sleeping = true;
+    config.threads = 1;
+    return config;
+}
+
+static void AddLattice(World& world)
+{
+    for (int i = 0; i < 200; i++)
+        world.addBall(20.0 + (i % 20) * 30.0, 20.0 + (i / 20) * 30.0, 10.0);
+}
+
+// Island ids are ball indices from the last sleep update, so a world saved
+// right after removing balls holds ids >= its ball count. Loading it and
+// waking an island must not index past the island table.
+static void TestRemoveSaveLoadStep()
+{
+    const double dt = 1.0 / 60.0;
+    World world(SleepyConfig());
+    AddLattice(world);
+    for (int s = 0; s < 40; s++)
+        world.step(dt);
+    CHECK(world.stats().sleepingBalls == 200);
+
+    for (int k = 0; k < 150; k++)
+        world.removeBall(world.ballCount() - 2);
+    CHECK(SaveWorld(world, TEST_FILE));
+
+    WorldFile file;
+    CHECK(file.Open(TEST_FILE));
+    if (!file.IsOpen())
+        return;
+    World loaded(file.Config());
+    file.LoadInto(loaded);
+    CHECK(loaded.ballCount() == 50);
+
+    // Lands on a sleeper: the solver asks to wake its island
+    const ParticleStore& p = loaded.particles();
+    loaded.addBall(p.x[0] + 5.0, p.y[0], 10.0);
+    loaded.step(dt);
+    loaded.step(dt);
+    CHECK(loaded.ballCount() == 51);
+    CHECK(loaded.stats().sleepingBalls < 50);
+}
+
+// Saves the lattice world asleep and overwrites ball 7's island id in the
+// file
+static bool SaveWithIsland(int32_t id)
+{
+    World world(SleepyConfig());
+    AddLattice(world);
+    for (int s = 0; s < 40; s++)
+        world.step(1.0 / 60.0);
+    if (!SaveWorld(world, TEST_FILE))
+        return false;
+
+    uint64_t offset = 0;
+    {
+        WorldFile file;
+        if (!file.Open(TEST_FILE))
+            return false;
+        offset = file.Header().arrays[WORLD_ARRAY_ISLAND].offset;
+    }
+
+    FILE* f = fopen(TEST_FILE, "r+b");
+    if (!f)
+        return false;
+    fseek(f, (long)offset + 7 * sizeof(int32_t), SEEK_SET);
+    bool ok = fwrite(&id, sizeof(id), 1, f) == 1;
+    return fclose(f) == 0 && ok;
+}
+
+// A negative island id is not a ball index: the file is rejected
+static void TestNegativeIslandRejected()
+{
+    CHECK(SaveWithIsland(-1));
+    WorldFile file;
+    CHECK(!file.Open(TEST_FILE));
+}
+
+// A huge island id (corrupt file) must not size the island tables: ids
+// past the ball count are renumbered on load
+static void TestHugeIslandRelabeled()
+{
+    CHECK(SaveWithIsland(0x7fffffff));
+    WorldFile file;
+    CHECK(file.Open(TEST_FILE));
+    if (!file.IsOpen())
+        return;
+    World loaded(file.Config());
+    file.LoadInto(loaded);
+
+    int n = loaded.ballCount();
+    const ParticleStore& p = loaded.particles();
+    for (int i = 0; i < n; i++)
+        CHECK(p.island[i] >= 0 && p.island[i] < 2 * n);
+
+    // Lands on ball 7: its island wakes through the renumbered id
+    loaded.addBall(p.x[7] + 5.0, p.y[7], 10.0);
+    loaded.step(1.0 / 60.0);
+    loaded.step(1.0 / 60.0);
+    CHECK(loaded.ballCount() == n + 1);
+    CHECK(loaded.stats().sleepingBalls < n);
+}
+
+int main()
+{
+    TestRemoveSaveLoadStep();
+    TestNegativeIslandRejected();
+    TestHugeIslandRelabeled();
+    remove(TEST_FILE);
+
+    if (failures > 0) {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("world file tests passed\n");
+    return 0;
+}
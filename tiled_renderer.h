@@ -0,0 +1,142 @@
+#pragma once
+
+#include <vector>
+#include <math.h>
+#include "sdl_draw.h"
+#include "engine/particle_store.h"
+#include "engine/thread_pool.h"
+
+// ----------------------------
+// Parallel tiled ball renderer
+// ----------------------------
+// The framebuffer is cut into TILE_SIZE x TILE_SIZE tiles. Every ball is
+// binned into each tile its bounding box touches (counting sort, ball order
+// kept inside every tile), then the tiles are rasterized concurrently, each
+// one clipped to its own rectangle.
+//
+// Tiles never share a pixel and each tile draws its balls in the original
+// order with the same span code as DrawBalls, so the last ball to cover a
+// pixel wins exactly as in the serial renderer: the output is bit-identical.
+#define TILE_SIZE 64
+
+struct TiledRenderer
+{
+    // Below this many balls one thread is faster than the hand-off
+    int minParallelBalls = 2000;
+
+    void Draw(SDL_Surface* surface, const ParticleStore& balls, ThreadPool& pool)
+    {
+        TRACE_SCOPE("FillCircle");
+        PERF_SCOPE(PERF_RENDER);
+        SurfaceLock lock(surface);
+        PixelTarget target = MakePixelTarget(surface);
+        SpanTables& tables = GlobalSpanTables();
+
+        int n = balls.size();
+
+        // FillRect fallback is not safe to call from several threads
+        if (!target.direct || pool.Size() == 1 || n < minParallelBalls) {
+            for (int i = 0; i < n; i++) {
+                tables.Reserve((int)balls.radius[i]);
+                FillCircleSpans(target, tables, balls.x[i], balls.y[i], balls.radius[i], balls.color[i]);
+            }
+            return;
+        }
+
+        tilesX = (surface->w + TILE_SIZE - 1) / TILE_SIZE;
+        tilesY = (surface->h + TILE_SIZE - 1) / TILE_SIZE;
+        int tileCount = tilesX * tilesY;
+
+        // Span tables must exist before the threads read them
+        double maxRadius = 0.0;
+        for (int i = 0; i < n; i++)
+            if (balls.radius[i] > maxRadius)
+                maxRadius = balls.radius[i];
+        tables.Reserve((int)maxRadius);
+
+        Bin(balls, tileCount);
+
+        pool.ParallelFor(tileCount, [&](int tile) {
+            TRACE_SCOPE("tile");
+            int begin = tileStart[tile];
+            int end = tileStart[tile + 1];
+            if (begin == end)
+                return;
+
+            PixelTarget clip = target;
+            clip.clipX0 = (tile % tilesX) * TILE_SIZE;
+            clip.clipY0 = (tile / tilesX) * TILE_SIZE;
+            clip.clipX1 = clip.clipX0 + TILE_SIZE;
+            clip.clipY1 = clip.clipY0 + TILE_SIZE;
+            if (clip.clipX1 > target.clipX1) clip.clipX1 = target.clipX1;
+            if (clip.clipY1 > target.clipY1) clip.clipY1 = target.clipY1;
+
+            for (int k = begin; k < end; k++) {
+                int i = tileItems[k];
+                FillCircleSpans(clip, tables, balls.x[i], balls.y[i], balls.radius[i], balls.color[i]);
+            }
+        });
+    }
+
+private:
+    int tilesX = 0, tilesY = 0;
+    std::vector<int> tileStart;   // tileCount + 1 offsets into tileItems
+    std::vector<int> tileItems;   // ball indices, grouped by tile
+    std::vector<int> cursor;
+
+    // Tile range covered by ball i's bounding box (one pixel of slack for
+    // the rounded centers of the span tables); false if fully off screen
+    bool TileRange(const ParticleStore& balls, int i, int& tx0, int& ty0, int& tx1, int& ty1) const
+    {
+        double r = balls.radius[i];
+        double width = tilesX * TILE_SIZE, height = tilesY * TILE_SIZE;
+        if (!(balls.x[i] + r >= -1.0 && balls.y[i] + r >= -1.0 &&
+              balls.x[i] - r <= width && balls.y[i] - r <= height))
+            return false;
+
+        int x0 = (int)floor(balls.x[i] - r) - 1;
+        int y0 = (int)floor(balls.y[i] - r) - 1;
+        int x1 = (int)ceil(balls.x[i] + r) + 1;
+        int y1 = (int)ceil(balls.y[i] + r) + 1;
+
+        tx0 = x0 < 0 ? 0 : x0 / TILE_SIZE;
+        ty0 = y0 < 0 ? 0 : y0 / TILE_SIZE;
+        tx1 = x1 / TILE_SIZE;
+        ty1 = y1 / TILE_SIZE;
+        if (tx1 >= tilesX) tx1 = tilesX - 1;
+        if (ty1 >= tilesY) ty1 = tilesY - 1;
+        return true;
+    }
+
+    void Bin(const ParticleStore& balls, int tileCount)
+    {
+        int n = balls.size();
+        tileStart.assign(tileCount + 1, 0);
+
+        // 1. Count
+        for (int i = 0; i < n; i++) {
+            int tx0, ty0, tx1, ty1;
+            if (!TileRange(balls, i, tx0, ty0, tx1, ty1))
+                continue;
+            for (int ty = ty0; ty <= ty1; ty++)
+                for (int tx = tx0; tx <= tx1; tx++)
+                    tileStart[ty * tilesX + tx + 1]++;
+        }
+
+        // 2. Prefix sum
+        for (int t = 0; t < tileCount; t++)
+            tileStart[t + 1] += tileStart[t];
+
+        // 3. Scatter in ball order
+        tileItems.resize(tileStart[tileCount]);
+        cursor.assign(tileStart.begin(), tileStart.end() - 1);
+        for (int i = 0; i < n; i++) {
+            int tx0, ty0, tx1, ty1;
+            if (!TileRange(balls, i, tx0, ty0, tx1, ty1))
+                continue;
+            for (int ty = ty0; ty <= ty1; ty++)
+                for (int tx = tx0; tx <= tx1; tx++)
+                    tileItems[cursor[ty * tilesX + tx]++] = i;
+        }
+    }
+};